@@ -8,6 +8,15 @@
 #define I_LAR_PANDORA_H 1
 
 #include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ProcessingFrame.h"
+#include "art/Framework/Core/ReplicatedProducer.h"
+
+#include "canvas/Persistency/Common/Ptr.h"
+
+#include "cetlib_except/exception.h"
+
+#include <utility>
+#include <vector>
 
 namespace recob {class Hit;}
 namespace pandora {class Pandora;}
@@ -17,25 +26,112 @@ namespace pandora {class Pandora;}
 namespace lar_pandora
 {
 
-typedef std::map< int, art::Ptr<recob::Hit> > IdToHitMap;
+/**
+ *  @brief  IdToHitMap class, mapping from the (dense, sequential, positive) pandora hit ids to art hits
+ *
+ *          The table is addressed directly by hit id, but offers the same lookup and (ordered) iteration semantics as
+ *          std::map<int, art::Ptr<recob::Hit> >. Ids that have never been assigned are skipped during iteration.
+ */
+class IdToHitMap
+{
+public:
+    typedef std::pair<int, art::Ptr<recob::Hit> > value_type;
+    typedef std::vector<value_type> Table;
+
+    /**
+     *  @brief  const_iterator class, visiting assigned entries in order of increasing hit id
+     */
+    class const_iterator
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  iter the position in the underlying table
+         *  @param  iterEnd the end of the underlying table
+         */
+        const_iterator(const Table::const_iterator &iter, const Table::const_iterator &iterEnd);
+
+        const value_type &operator*() const;
+        const value_type *operator->() const;
+        const_iterator &operator++();
+        bool operator==(const const_iterator &rhs) const;
+        bool operator!=(const const_iterator &rhs) const;
+
+    private:
+        Table::const_iterator   m_iter;         ///< The position in the underlying table
+        Table::const_iterator   m_iterEnd;      ///< The end of the underlying table
+    };
+
+    /**
+     *  @brief  Default constructor
+     */
+    IdToHitMap();
+
+    /**
+     *  @brief  Access the art hit for a given hit id, creating an (empty) entry if required
+     *
+     *  @param  id the hit id, which must be positive
+     */
+    art::Ptr<recob::Hit> &operator[](const int id);
+
+    /**
+     *  @brief  Find the entry for a given hit id, returning end() if there is no such entry
+     *
+     *  @param  id the hit id
+     */
+    const_iterator find(const int id) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     *  @brief  Get the number of assigned entries
+     */
+    size_t size() const;
+
+    /**
+     *  @brief  Whether there are no assigned entries
+     */
+    bool empty() const;
+
+    /**
+     *  @brief  Reserve space for hit ids up to a given value
+     *
+     *  @param  maxId the maximum expected hit id
+     */
+    void reserve(const size_t maxId);
+
+    /**
+     *  @brief  Remove all entries
+     */
+    void clear();
+
+private:
+    Table       m_table;        ///< The table, in which the entry for hit id n is at index n - 1; unassigned entries have id 0
+    size_t      m_size;         ///< The number of assigned entries
+};
 
 /**
- *  @brief  ILArPandora class
+ *  @brief  ILArPandoraT class template, the interface of the LArPandora producers on top of an art producer base class: art::EDProducer
+ *          for the legacy producers, with one tree of pandora instances per job, or art::ReplicatedProducer, with one per art schedule
  */
-class ILArPandora : public art::EDProducer
+template <typename TProducer>
+class ILArPandoraT : public TProducer
 {
 public:
     /**
      *  @brief  Constructor
      *
      *  @param  pset the parameter set
+     *  @param  pFrame the address of the processing frame of the schedule that owns a replicated producer, nullptr for a legacy producer
      */
-    ILArPandora(fhicl::ParameterSet const &pset);
+    ILArPandoraT(fhicl::ParameterSet const &pset, const art::ProcessingFrame *const pFrame = nullptr);
 
     /**
      *  @brief  Destructor
      */
-    virtual ~ILArPandora();
+    virtual ~ILArPandoraT();
 
 protected:
     /**
@@ -79,20 +175,227 @@ protected:
      */
     virtual void ResetPandoraInstances() = 0;
 
+    /**
+     *  @brief  Create the fallback pandora instance, used in place of the primary instance for events exceeding the reconstruction budget.
+     *          Only called if a budget is configured; the default implementation throws, for producers without a fallback
+     */
+    virtual void CreateFallbackPandoraInstance();
+
+    /**
+     *  @brief  Configure the fallback pandora instance, with a cheaper steering than the primary instance
+     */
+    virtual void ConfigureFallbackPandoraInstance();
+
+    /**
+     *  @brief  Run the fallback pandora instance
+     */
+    virtual void RunFallbackPandoraInstance();
+
+    /**
+     *  @brief  Reset the fallback pandora instance
+     */
+    virtual void ResetFallbackPandoraInstance();
+
     const pandora::Pandora     *m_pPrimaryPandora;          ///< The address of the primary pandora instance
+    const pandora::Pandora     *m_pFallbackPandora;         ///< The address of the fallback pandora instance, nullptr if not created
 };
 
+typedef ILArPandoraT<art::EDProducer> ILArPandora;
+typedef ILArPandoraT<art::ReplicatedProducer> IReplicatedLArPandora;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <>
+inline ILArPandoraT<art::EDProducer>::ILArPandoraT(fhicl::ParameterSet const &/*pset*/, const art::ProcessingFrame *const /*pFrame*/) :
+    m_pPrimaryPandora(nullptr),
+    m_pFallbackPandora(nullptr)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <>
+inline ILArPandoraT<art::ReplicatedProducer>::ILArPandoraT(fhicl::ParameterSet const &pset, const art::ProcessingFrame *const pFrame) :
+    art::ReplicatedProducer(pset, pFrame ? *pFrame : throw cet::exception("LArPandora") << " ILArPandoraT::ILArPandoraT --- replicated producers need a processing frame "),
+    m_pPrimaryPandora(nullptr),
+    m_pFallbackPandora(nullptr)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+inline ILArPandoraT<TProducer>::~ILArPandoraT()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+inline void ILArPandoraT<TProducer>::CreateFallbackPandoraInstance()
+{
+    throw cet::exception("LArPandora") << " ILArPandora::CreateFallbackPandoraInstance --- this producer has no fallback pandora instance; "
+                                       << "use the Empty BudgetFallback, or remove the MaxEventHits and MaxEventSeconds budget ";
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+inline void ILArPandoraT<TProducer>::ConfigureFallbackPandoraInstance()
+{
+    throw cet::exception("LArPandora") << " ILArPandora::ConfigureFallbackPandoraInstance --- this producer has no fallback pandora instance ";
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+inline void ILArPandoraT<TProducer>::RunFallbackPandoraInstance()
+{
+    throw cet::exception("LArPandora") << " ILArPandora::RunFallbackPandoraInstance --- this producer has no fallback pandora instance ";
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+inline void ILArPandoraT<TProducer>::ResetFallbackPandoraInstance()
+{
+    throw cet::exception("LArPandora") << " ILArPandora::ResetFallbackPandoraInstance --- this producer has no fallback pandora instance ";
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline IdToHitMap::const_iterator::const_iterator(const Table::const_iterator &iter, const Table::const_iterator &iterEnd) :
+    m_iter(iter),
+    m_iterEnd(iterEnd)
+{
+    while ((m_iter != m_iterEnd) && (0 == m_iter->first))
+        ++m_iter;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const IdToHitMap::value_type &IdToHitMap::const_iterator::operator*() const
+{
+    return *m_iter;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const IdToHitMap::value_type *IdToHitMap::const_iterator::operator->() const
+{
+    return &(*m_iter);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline IdToHitMap::const_iterator &IdToHitMap::const_iterator::operator++()
+{
+    do
+    {
+        ++m_iter;
+    }
+    while ((m_iter != m_iterEnd) && (0 == m_iter->first));
+
+    return *this;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool IdToHitMap::const_iterator::operator==(const const_iterator &rhs) const
+{
+    return (m_iter == rhs.m_iter);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool IdToHitMap::const_iterator::operator!=(const const_iterator &rhs) const
+{
+    return (m_iter != rhs.m_iter);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline IdToHitMap::IdToHitMap() :
+    m_size(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline art::Ptr<recob::Hit> &IdToHitMap::operator[](const int id)
+{
+    if (id <= 0)
+        throw cet::exception("LArPandora") << " IdToHitMap::operator[] --- hit ids must be positive, found " << id;
+
+    const size_t index(static_cast<size_t>(id) - 1);
+
+    if (index >= m_table.size())
+        m_table.resize(index + 1, value_type(0, art::Ptr<recob::Hit>()));
+
+    value_type &entry(m_table[index]);
+
+    if (0 == entry.first)
+    {
+        entry.first = id;
+        ++m_size;
+    }
+
+    return entry.second;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline IdToHitMap::const_iterator IdToHitMap::find(const int id) const
+{
+    if ((id <= 0) || (static_cast<size_t>(id) > m_table.size()) || (0 == m_table[id - 1].first))
+        return this->end();
+
+    return const_iterator(m_table.begin() + (id - 1), m_table.end());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline IdToHitMap::const_iterator IdToHitMap::begin() const
+{
+    return const_iterator(m_table.begin(), m_table.end());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline IdToHitMap::const_iterator IdToHitMap::end() const
+{
+    return const_iterator(m_table.end(), m_table.end());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline size_t IdToHitMap::size() const
+{
+    return m_size;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool IdToHitMap::empty() const
+{
+    return (0 == m_size);
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-inline ILArPandora::ILArPandora(fhicl::ParameterSet const &/*pset*/) :
-    m_pPrimaryPandora(nullptr)
+inline void IdToHitMap::reserve(const size_t maxId)
 {
+    m_table.reserve(maxId);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-inline ILArPandora::~ILArPandora()
+inline void IdToHitMap::clear()
 {
+    m_table.clear();
+    m_size = 0;
 }
 
 } // namespace lar_pandora
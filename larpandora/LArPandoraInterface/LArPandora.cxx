@@ -6,14 +6,20 @@
  */
 
 #include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
 #include "art/Framework/Services/Optional/TFileService.h"
 #include "cetlib/cpu_timer.h"
 
+#include "tbb/task_group.h"
+
 #include "lardata/DetectorInfoServices/DetectorPropertiesService.h"
 #include "lardata/DetectorInfoServices/DetectorClocksService.h"
 
 #include "larcore/Geometry/Geometry.h"
 
+#include "larevt/CalibrationDBI/Interface/ChannelStatusService.h"
+#include "larevt/CalibrationDBI/Interface/ChannelStatusProvider.h"
+
 #include "lardataobj/AnalysisBase/T0.h"
 #include "lardataobj/RecoBase/Cluster.h"
 #include "lardataobj/RecoBase/Hit.h"
@@ -28,6 +34,9 @@
 
 #include "Api/PandoraApi.h"
 
+#include "Objects/Cluster.h"
+#include "Objects/ParticleFlowObject.h"
+
 #include "larpandoracontent/LArContent.h"
 #include "larpandoracontent/LArHelpers/LArPfoHelper.h"
 
@@ -35,15 +44,20 @@
 #include "larpandora/LArPandoraInterface/LArPandoraHelper.h"
 #include "larpandora/LArPandoraInterface/LArPandoraInput.h"
 #include "larpandora/LArPandoraInterface/LArPandoraOutput.h"
+#include "larpandora/LArPandoraInterface/LArPandoraPooledObjects.h"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <iterator>
 #include <limits>
 
 namespace lar_pandora
 {
 
-LArPandora::LArPandora(fhicl::ParameterSet const &pset) :
-    ILArPandora(pset),
+template <typename TProducer>
+LArPandoraT<TProducer>::LArPandoraT(fhicl::ParameterSet const &pset, const art::ProcessingFrame *const pFrame) :
+    ILArPandoraT<TProducer>(pset, pFrame),
     m_configFile(pset.get<std::string>("ConfigFile")),
     m_shouldRunAllHitsCosmicReco(pset.get<bool>("ShouldRunAllHitsCosmicReco")),
     m_shouldRunStitching(pset.get<bool>("ShouldRunStitching")),
@@ -60,11 +74,29 @@ LArPandora::LArPandora(fhicl::ParameterSet const &pset) :
     m_hitfinderModuleLabel(pset.get<std::string>("HitFinderModuleLabel")),
     m_backtrackerModuleLabel(pset.get<std::string>("BackTrackerModuleLabel","")),
     m_allOutcomesInstanceLabel(pset.get<std::string>("AllOutcomesInstanceLabel", "allOutcomes")),
+    m_eventMetadataInstanceLabel(pset.get<std::string>("EventMetadataInstanceLabel", "eventMetadata")),
+    m_readoutGapCacheFile(pset.get<std::string>("ReadoutGapCacheFile", "")),
     m_enableProduction(pset.get<bool>("EnableProduction", true)),
     m_enableDetectorGaps(pset.get<bool>("EnableLineGaps", true)),
     m_enableMCParticles(pset.get<bool>("EnableMCParticles", false)),
     m_enableTriggerMCParticle(pset.get<bool>("EnableTriggerMCParticle", false)),
-    m_lineGapsCreated(false)
+    m_useSimChannelSweep(pset.get<bool>("UseSimChannelSweep", false)),
+    m_enableConcurrentInput(pset.get<bool>("EnableConcurrentInput", false)),
+    m_badChannelsLoaded(false),
+    m_badChannelKey(0),
+    m_geometryKey(0),
+    m_hitFilterDriftVolumeXMargin(pset.get<double>("HitFilterDriftVolumeXMargin", 0.)),
+    m_instrumentSliceOccupancy(false),
+    m_maxEventHits(pset.get<unsigned int>("MaxEventHits", 0)),
+    m_maxEventSeconds(pset.get<double>("MaxEventSeconds", 0.)),
+    m_enableEventBudget((m_maxEventHits > 0) || (m_maxEventSeconds > 0.)),
+    m_budgetFallback(larpandoraobj::EventMetadata::kCosmicOnlyFallback),
+    m_budgetRunSeconds(0.),
+    m_budgetRunHits(0),
+    m_nBudgetFallbacks(0),
+    m_nHitBudgetExceeded(0),
+    m_nTimeBudgetExceeded(0),
+    m_nTimeBudgetOverruns(0)
 {
     m_inputSettings.m_useHitWidths = pset.get<bool>("UseHitWidths", true);
     m_inputSettings.m_useBirksCorrection = pset.get<bool>("UseBirksCorrection", false);
@@ -77,10 +109,66 @@ LArPandora::LArPandora(fhicl::ParameterSet const &pset) :
     m_inputSettings.m_mips_if_negative = pset.get<double>("MipsIfNegative", 0.);
     m_inputSettings.m_mips_to_gev = pset.get<double>("MipsToGeV", 3.5e-4);
     m_inputSettings.m_recombination_factor = pset.get<double>("RecombinationFactor", 0.63);
+    m_inputSettings.m_birksTableMaxDQdX = pset.get<double>("BirksTableMaxDQdX", 5.e5);
+    m_inputSettings.m_birksTableNodes = pset.get<unsigned int>("BirksTableNodes", 5001);
+    m_inputSettings.m_usePooledInputObjects = pset.get<bool>("UsePooledInputObjects", false);
+    m_hitFilter.m_minIntegral = pset.get<double>("HitFilterMinIntegral", m_hitFilter.m_minIntegral);
+    m_hitFilter.m_minPeakTime = pset.get<double>("HitFilterMinPeakTime", m_hitFilter.m_minPeakTime);
+    m_hitFilter.m_maxPeakTime = pset.get<double>("HitFilterMaxPeakTime", m_hitFilter.m_maxPeakTime);
+    m_hitFilter.m_useDriftVolumeXRange = pset.get<bool>("HitFilterUseDriftVolumeXRange", false);
+    m_hitFilter.m_vetoBadChannels = pset.get<bool>("HitFilterVetoBadChannels", false);
     m_outputSettings.m_pProducer = this;
     m_outputSettings.m_shouldRunStitching = m_shouldRunStitching;
     m_outputSettings.m_isNeutrinoRecoOnlyNoSlicing = (!m_shouldRunSlicing && m_shouldRunNeutrinoRecoOption && !m_shouldRunCosmicRecoOption);
     m_outputSettings.m_hitfinderModuleLabel = m_hitfinderModuleLabel;
+    m_outputSettings.m_shouldBuildClustersInParallel = pset.get<bool>("EnableParallelClusterBuilding", false);
+    m_outputSettings.m_clusterParameterLevel = LArPandoraOutput::GetClusterParameterLevel(pset.get<std::string>("ClusterParameterLevel", "Full"));
+    m_outputSettings.m_shouldProduceAllOutcomes = false;
+    m_outputSettings.m_allOutcomesInstanceLabel = m_allOutcomesInstanceLabel;
+
+    if (m_outputSettings.m_shouldBuildClustersInParallel && (LArPandoraOutput::kClusterFull == m_outputSettings.m_clusterParameterLevel))
+    {
+        mf::LogWarning("LArPandora") << " LArPandora::LArPandora - EnableParallelClusterBuilding is ignored for the Full ClusterParameterLevel: the cluster "
+                                     << "parameter algorithm uses services and ROOT, which are not safe on worker threads, so clusters are built serially " << std::endl;
+        m_outputSettings.m_shouldBuildClustersInParallel = false;
+    }
+
+    // The production profile sets the default for each optional product, which may then be switched individually
+    const std::string productionProfile(pset.get<std::string>("ProductionProfile", "Full"));
+    if ("Full" != productionProfile && "Summary" != productionProfile)
+        throw cet::exception("LArPandora") << " LArPandora::LArPandora --- unknown production profile " << productionProfile;
+
+    const bool isFullProfile("Full" == productionProfile);
+    m_outputSettings.m_shouldProduceSpacePoints = pset.get<bool>("ProduceSpacePoints", isFullProfile);
+    m_outputSettings.m_shouldProduceClusters = pset.get<bool>("ProduceClusters", isFullProfile);
+    m_outputSettings.m_shouldProduceVertices = pset.get<bool>("ProduceVertices", isFullProfile);
+    m_outputSettings.m_shouldProduceMetadata = pset.get<bool>("ProduceMetadata", true);
+    m_outputSettings.m_shouldProduceSlices = pset.get<bool>("ProduceSlices", true);
+    m_outputSettings.m_shouldProduceCompactSpacePoints = pset.get<bool>("ProduceCompactSpacePoints", false);
+    m_outputSettings.m_compactSpacePointResolution = pset.get<float>("CompactSpacePointResolution", 0.01f);
+
+    // Events exceeding the budget run a cheaper steering, in a separate pandora instance, or produce no particles at all
+    const std::string budgetFallback(pset.get<std::string>("BudgetFallback", "CosmicOnly"));
+    if ("CosmicOnly" == budgetFallback)
+    {
+        m_budgetFallback = larpandoraobj::EventMetadata::kCosmicOnlyFallback;
+    }
+    else if ("Empty" == budgetFallback)
+    {
+        m_budgetFallback = larpandoraobj::EventMetadata::kEmptyFallback;
+    }
+    else
+    {
+        throw cet::exception("LArPandora") << " LArPandora::LArPandora --- unknown budget fallback " << budgetFallback;
+    }
+
+    if (pset.get<bool>("EnableInstrumentation", false))
+    {
+        m_pInstrumentation.reset(new LArPandoraInstrumentation(pset.get<bool>("InstrumentationTree", true), pset.get<std::string>("InstrumentationJsonFile", ""),
+            pFrame ? pFrame->scheduleID().id() : 0));
+        m_outputSettings.m_pInstrumentation = m_pInstrumentation.get();
+        m_instrumentSliceOccupancy = pset.get<bool>("InstrumentSliceOccupancy", false);
+    }
 
     if (m_enableProduction)
     {
@@ -91,37 +179,75 @@ LArPandora::LArPandora(fhicl::ParameterSet const &pset) :
 
         for (const std::string &instanceName : instanceNames)
         {
-            produces< std::vector<recob::PFParticle> >(instanceName);
-            produces< std::vector<recob::SpacePoint> >(instanceName);
-            produces< std::vector<recob::Cluster> >(instanceName);
-            produces< std::vector<recob::Vertex> >(instanceName);
-            produces< std::vector<larpandoraobj::PFParticleMetadata> >(instanceName);
-            produces< std::vector<recob::Slice> >(instanceName);
-
-            produces< art::Assns<recob::PFParticle, larpandoraobj::PFParticleMetadata> >(instanceName);
-            produces< art::Assns<recob::PFParticle, recob::SpacePoint> >(instanceName);
-            produces< art::Assns<recob::PFParticle, recob::Cluster> >(instanceName);
-            produces< art::Assns<recob::PFParticle, recob::Vertex> >(instanceName);
-            produces< art::Assns<recob::PFParticle, recob::Slice> >(instanceName);
-            produces< art::Assns<recob::SpacePoint, recob::Hit> >(instanceName);
-            produces< art::Assns<recob::Cluster, recob::Hit> >(instanceName);
-            produces< art::Assns<recob::Slice, recob::Hit> >(instanceName);
+            this->template produces< std::vector<recob::PFParticle> >(instanceName);
+
+            if (m_outputSettings.m_shouldProduceSpacePoints)
+            {
+                this->template produces< std::vector<recob::SpacePoint> >(instanceName);
+                this->template produces< art::Assns<recob::PFParticle, recob::SpacePoint> >(instanceName);
+                this->template produces< art::Assns<recob::SpacePoint, recob::Hit> >(instanceName);
+            }
+
+            if (m_outputSettings.m_shouldProduceCompactSpacePoints)
+                this->template produces< larpandoraobj::CompactSpacePoints >(instanceName);
+
+            if (m_outputSettings.m_shouldProduceClusters)
+            {
+                this->template produces< std::vector<recob::Cluster> >(instanceName);
+                this->template produces< art::Assns<recob::PFParticle, recob::Cluster> >(instanceName);
+                this->template produces< art::Assns<recob::Cluster, recob::Hit> >(instanceName);
+            }
+
+            if (m_outputSettings.m_shouldProduceVertices)
+            {
+                this->template produces< std::vector<recob::Vertex> >(instanceName);
+                this->template produces< art::Assns<recob::PFParticle, recob::Vertex> >(instanceName);
+            }
+
+            if (m_outputSettings.m_shouldProduceMetadata)
+            {
+                this->template produces< std::vector<larpandoraobj::PFParticleMetadata> >(instanceName);
+                this->template produces< art::Assns<recob::PFParticle, larpandoraobj::PFParticleMetadata> >(instanceName);
+            }
+
+            if (m_outputSettings.m_shouldProduceSlices)
+            {
+                this->template produces< std::vector<recob::Slice> >(instanceName);
+                this->template produces< art::Assns<recob::PFParticle, recob::Slice> >(instanceName);
+                this->template produces< art::Assns<recob::Slice, recob::Hit> >(instanceName);
+            }
 
             if (m_outputSettings.m_shouldRunStitching)
             {
-                produces< std::vector<anab::T0> >(instanceName);
-                produces< art::Assns<recob::PFParticle, anab::T0> >(instanceName);
+                this->template produces< std::vector<anab::T0> >(instanceName);
+                this->template produces< art::Assns<recob::PFParticle, anab::T0> >(instanceName);
             }
         }
+
+        if (m_enableEventBudget)
+            this->template produces< larpandoraobj::EventMetadata >(m_eventMetadataInstanceLabel);
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandora::beginJob()
+template <typename TProducer>
+void LArPandoraT<TProducer>::beginJob()
 {
-    LArDriftVolumeList driftVolumeList;
-    LArPandoraGeometry::LoadGeometry(driftVolumeList, m_driftVolumeMap);
+    if (m_pInstrumentation)
+        m_pInstrumentation->BeginJob();
+
+    // ATTN The geometry is loaded once and shared, read-only, with any other producers and schedules; only the lookup table, which depends
+    // upon the run, is owned by each producer
+    m_pDetectorGeometry = LArPandoraGeometry::GetDetectorGeometry();
+    const LArDriftVolumeList &driftVolumeList(m_pDetectorGeometry->GetDriftVolumeList());
+    LArPandoraGeometry::LoadDetectorLookupTable(m_pDetectorGeometry->GetDriftVolumeMap(), m_detectorLookupTable);
+
+    if (m_hitFilter.m_useDriftVolumeXRange)
+        this->LoadHitFilterDriftVolumes();
+
+    if (!m_readoutGapCacheFile.empty())
+        m_geometryKey = LArPandoraGeometry::GetGeometryKey();
 
     this->CreatePandoraInstances();
 
@@ -136,41 +262,245 @@ void LArPandora::beginJob()
 
     // If using global drift volume approach, pass details of gaps between daughter volumes to the pandora instance
     if (m_enableDetectorGaps)
-    {
-        LArDetectorGapList listOfGaps;
-        LArPandoraGeometry::LoadDetectorGaps(listOfGaps);
-        LArPandoraInput::CreatePandoraDetectorGaps(m_inputSettings, driftVolumeList, listOfGaps);
-    }
+        LArPandoraInput::CreatePandoraDetectorGaps(m_inputSettings, driftVolumeList, m_pDetectorGeometry->GetDetectorGapList());
 
     // Parse Pandora settings xml files
     this->ConfigurePandoraInstances();
+
+    if (m_enableEventBudget && (larpandoraobj::EventMetadata::kCosmicOnlyFallback == m_budgetFallback))
+    {
+        this->CreateFallbackPandoraInstance();
+
+        if (!m_pFallbackPandora)
+            throw cet::exception("LArPandora") << " LArPandora::beginJob - failed to create fallback Pandora instance " << std::endl;
+
+        m_fallbackInputSettings = m_inputSettings;
+        m_fallbackInputSettings.m_pPrimaryPandora = m_pFallbackPandora;
+        m_fallbackOutputSettings = m_outputSettings;
+        m_fallbackOutputSettings.m_pPrimaryPandora = m_pFallbackPandora;
+        m_fallbackOutputSettings.m_isNeutrinoRecoOnlyNoSlicing = false;
+
+        LArPandoraInput::CreatePandoraLArTPCs(m_fallbackInputSettings, driftVolumeList);
+
+        if (m_enableDetectorGaps)
+            LArPandoraInput::CreatePandoraDetectorGaps(m_fallbackInputSettings, driftVolumeList, m_pDetectorGeometry->GetDetectorGapList());
+
+        this->ConfigureFallbackPandoraInstance();
+    }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandora::produce(art::Event &evt)
+template <typename TProducer>
+void LArPandoraT<TProducer>::beginRun(art::Run &/*run*/)
 {
-    IdToHitMap idToHitMap;
-    this->CreatePandoraInput(evt, idToHitMap);
-    this->RunPandoraInstances();
-    this->ProcessPandoraOutput(evt, idToHitMap);
-    this->ResetPandoraInstances();
+    // Detector properties (e.g. trigger offset, drift velocity) may change at run boundaries, so refresh the lookup table here
+    LArPandoraGeometry::LoadDetectorLookupTable(m_pDetectorGeometry->GetDriftVolumeMap(), m_detectorLookupTable);
+
+    // The charge to energy conversion depends upon the same detector properties
+    LArPandoraInput::LoadHitConversionConstants(m_inputSettings, m_hitConversionConstants);
+
+    if (!m_hitConversionConstants.m_birksTable.empty())
+    {
+        mf::LogDebug("LArPandora") << " LArPandora::beginRun - tabulated Birks correction up to dQ/dx " << m_hitConversionConstants.m_birksTableMaxDQdX
+                                   << " e/cm, max deviation from exact " << LArPandoraInput::GetBirksTableMaxDeviation(m_inputSettings, m_hitConversionConstants)
+                                   << " mips " << std::endl;
+    }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandora::CreatePandoraInput(art::Event &evt, IdToHitMap &idToHitMap)
+template <typename TProducer>
+void LArPandoraT<TProducer>::endJob()
 {
-    // ATTN Should complete gap creation in begin job callback, but channel status service functionality unavailable at that point
-    if (!m_lineGapsCreated && m_enableDetectorGaps)
+    mf::LogInfo("LArPandora") << " LArPandora::endJob - hit filter: " << m_hitFilterCounters.m_nInput << " input hits, "
+                              << m_hitFilterCounters.m_nAccepted << " accepted; rejected " << m_hitFilterCounters.m_nNonFinite << " non-finite, "
+                              << m_hitFilterCounters.m_nBelowMinIntegral << " below integral threshold, "
+                              << m_hitFilterCounters.m_nOutsideTickWindow << " outside tick window, "
+                              << m_hitFilterCounters.m_nOutsideDriftVolume << " outside drift volume, "
+                              << m_hitFilterCounters.m_nBadChannel << " on bad channels " << std::endl;
+
+    if (m_enableEventBudget)
     {
-        LArPandoraInput::CreatePandoraReadoutGaps(m_inputSettings, m_driftVolumeMap);
-        m_lineGapsCreated = true;
+        mf::LogInfo("LArPandora") << " LArPandora::endJob - reconstruction budget: " << m_nBudgetFallbacks << " events used the "
+                                  << ((larpandoraobj::EventMetadata::kCosmicOnlyFallback == m_budgetFallback) ? "cosmic-only" : "empty") << " fallback ("
+                                  << m_nHitBudgetExceeded << " exceeded the hit budget, " << m_nTimeBudgetExceeded << " exceeded the predicted time budget); "
+                                  << m_nTimeBudgetOverruns << " full reconstructions overran the time budget " << std::endl;
+    }
+
+    if (m_pInstrumentation)
+        m_pInstrumentation->Summarise();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void LArPandoraT<TProducer>::UpdateBadChannels()
+{
+    if (!m_enableDetectorGaps && !m_hitFilter.m_vetoBadChannels)
+        return;
+
+    const lariov::ChannelStatusProvider &channelStatus(art::ServiceHandle<lariov::ChannelStatusService>()->GetProvider());
+    const lariov::ChannelStatusProvider::ChannelSet_t badChannels(channelStatus.BadChannels());
+    const size_t badChannelKey(LArPandoraGeometry::GetBadChannelKey(badChannels));
+
+    // Only rebuild the readout gaps and the bad channel veto if the set of bad channels has changed
+    if (m_badChannelsLoaded && (badChannelKey == m_badChannelKey))
+        return;
+
+    if (m_enableDetectorGaps)
+        this->UpdateReadoutGaps(badChannels, badChannelKey);
+
+    if (m_hitFilter.m_vetoBadChannels)
+        this->LoadHitFilterBadChannels(badChannels);
+
+    m_badChannelKey = badChannelKey;
+    m_badChannelsLoaded = true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void LArPandoraT<TProducer>::UpdateReadoutGaps(const lariov::ChannelStatusProvider::ChannelSet_t &badChannels, const size_t badChannelKey)
+{
+    LArReadoutGapList readoutGapList;
+
+    if (m_readoutGapCacheFile.empty() || !LArPandoraGeometry::ReadReadoutGaps(m_readoutGapCacheFile, m_geometryKey, badChannelKey, readoutGapList))
+    {
+        LArPandoraGeometry::LoadReadoutGaps(badChannels, readoutGapList);
+
+        if (!m_readoutGapCacheFile.empty())
+            LArPandoraGeometry::WriteReadoutGaps(m_readoutGapCacheFile, m_geometryKey, badChannelKey, readoutGapList);
+    }
+
+    std::sort(readoutGapList.begin(), readoutGapList.end());
+
+    // ATTN Pandora line gaps cannot be removed, so only the gaps not already known to the pandora instance are created here
+    LArReadoutGapList newReadoutGapList;
+    std::set_difference(readoutGapList.begin(), readoutGapList.end(), m_readoutGapList.begin(), m_readoutGapList.end(),
+        std::back_inserter(newReadoutGapList));
+
+    if (!std::includes(readoutGapList.begin(), readoutGapList.end(), m_readoutGapList.begin(), m_readoutGapList.end()))
+    {
+        mf::LogWarning("LArPandora") << " LArPandora::UpdateReadoutGaps - some channels are no longer bad, but existing line gaps cannot be removed "
+                                     << "from the pandora instance " << std::endl;
+    }
+
+    LArPandoraInput::CreatePandoraReadoutGaps(m_inputSettings, m_pDetectorGeometry->GetDriftVolumeMap(), m_detectorLookupTable, newReadoutGapList);
+
+    if (m_pFallbackPandora)
+        LArPandoraInput::CreatePandoraReadoutGaps(m_fallbackInputSettings, m_pDetectorGeometry->GetDriftVolumeMap(), m_detectorLookupTable, newReadoutGapList);
+
+    LArReadoutGapList mergedReadoutGapList;
+    std::set_union(readoutGapList.begin(), readoutGapList.end(), m_readoutGapList.begin(), m_readoutGapList.end(),
+        std::back_inserter(mergedReadoutGapList));
+
+    m_readoutGapList.swap(mergedReadoutGapList);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void LArPandoraT<TProducer>::LoadHitFilterDriftVolumes()
+{
+    m_hitFilter.m_driftVolumeMinX.clear();
+    m_hitFilter.m_driftVolumeMaxX.clear();
+
+    // ATTN The table is indexed by drift volume id, as assigned to each hit, not by the tpc id keying the drift volume map
+    for (const LArDriftVolume &driftVolume : m_pDetectorGeometry->GetDriftVolumeList())
+    {
+        const unsigned int volumeID(driftVolume.GetVolumeID());
+
+        if (volumeID >= m_hitFilter.m_driftVolumeMinX.size())
+        {
+            // ATTN Volumes absent from the map keep an unbounded range
+            m_hitFilter.m_driftVolumeMinX.resize(volumeID + 1, -std::numeric_limits<double>::max());
+            m_hitFilter.m_driftVolumeMaxX.resize(volumeID + 1, std::numeric_limits<double>::max());
+        }
+
+        m_hitFilter.m_driftVolumeMinX[volumeID] = driftVolume.GetCenterX() - 0.5 * driftVolume.GetWidthX() - m_hitFilterDriftVolumeXMargin;
+        m_hitFilter.m_driftVolumeMaxX[volumeID] = driftVolume.GetCenterX() + 0.5 * driftVolume.GetWidthX() + m_hitFilterDriftVolumeXMargin;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void LArPandoraT<TProducer>::LoadHitFilterBadChannels(const lariov::ChannelStatusProvider::ChannelSet_t &badChannels)
+{
+    m_hitFilter.m_isBadChannel.assign(art::ServiceHandle<geo::Geometry const>()->Nchannels(), false);
+
+    for (const raw::ChannelID_t channel : badChannels)
+    {
+        if (channel < m_hitFilter.m_isBadChannel.size())
+            m_hitFilter.m_isBadChannel[channel] = true;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void LArPandoraT<TProducer>::produce(art::Event &evt)
+{
+    LArPandoraInstrumentation *const pInstrumentation(m_pInstrumentation.get());
+
+    if (pInstrumentation)
+        pInstrumentation->BeginEvent(evt);
+
+    {
+        LArPandoraInstrumentation::ScopedTimer totalTimer(pInstrumentation, LArPandoraInstrumentation::kTotal);
+
+        IdToHitMap idToHitMap;
+        this->CreatePandoraInput(evt, idToHitMap);
+
+        const std::chrono::steady_clock::time_point runStart(std::chrono::steady_clock::now());
+        {
+            LArPandoraInstrumentation::ScopedTimer runTimer(pInstrumentation, LArPandoraInstrumentation::kRunPandora);
+
+            if (larpandoraobj::EventMetadata::kNoFallback == m_eventBudget.m_fallback)
+            {
+                this->RunPandoraInstances();
+            }
+            else if (larpandoraobj::EventMetadata::kCosmicOnlyFallback == m_eventBudget.m_fallback)
+            {
+                this->RunFallbackPandoraInstance();
+            }
+        }
+        this->RecordEventRunTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count());
+
+        if (m_instrumentSliceOccupancy && (larpandoraobj::EventMetadata::kNoFallback == m_eventBudget.m_fallback))
+            this->RecordSliceOccupancy();
+
+        this->ProcessPandoraOutput(evt, idToHitMap);
+
+        LArPandoraInstrumentation::ScopedTimer resetTimer(pInstrumentation, LArPandoraInstrumentation::kReset);
+
+        if (larpandoraobj::EventMetadata::kNoFallback == m_eventBudget.m_fallback)
+        {
+            this->ResetPandoraInstances();
+        }
+        else if (larpandoraobj::EventMetadata::kCosmicOnlyFallback == m_eventBudget.m_fallback)
+        {
+            this->ResetFallbackPandoraInstance();
+        }
     }
 
+    if (pInstrumentation)
+        pInstrumentation->EndEvent();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void LArPandoraT<TProducer>::CreatePandoraInput(art::Event &evt, IdToHitMap &idToHitMap)
+{
+    // ATTN Can't complete gap creation at a begin job or run callback, as the channel status service may only be updated per event
+    this->UpdateBadChannels();
+
     HitVector artHits;
     SimChannelVector artSimChannels;
     HitsToTrackIDEs artHitsToTrackIDEs;
+    HitTrackIDETable artHitTrackIDETable;
     MCParticleVector artMCParticleVector;
     RawMCParticleVector generatorArtMCParticleVector;
     MCTruthToMCParticles artMCTruthToMCParticles;
@@ -178,21 +508,25 @@ void LArPandora::CreatePandoraInput(art::Event &evt, IdToHitMap &idToHitMap)
 
     LArPandoraHelper::CollectHits(evt, m_hitfinderModuleLabel, artHits);
 
-    if (m_enableMCParticles && !evt.isRealData())
+    const bool shouldCollectTruth(m_enableMCParticles && !evt.isRealData());
+    LArPandoraInput::HitBatch hitBatch;
+    LArPandoraInput::HitFilterCounters hitFilterCounters;
+
+    LArPandoraInstrumentation *const pInstrumentation(m_pInstrumentation.get());
+
+    // ATTN Event products and legacy services may only be accessed from the module thread, so all truth products are collected here
+    if (shouldCollectTruth)
     {
+        LArPandoraInstrumentation::ScopedTimer timer(pInstrumentation, LArPandoraInstrumentation::kInputTruthCollection);
         LArPandoraHelper::CollectMCParticles(evt, m_geantModuleLabel, artMCParticleVector);
 
         if (!m_generatorModuleLabel.empty())
             LArPandoraHelper::CollectGeneratorMCParticles(evt, m_generatorModuleLabel, generatorArtMCParticleVector);
 
         LArPandoraHelper::CollectMCParticles(evt, m_geantModuleLabel, artMCTruthToMCParticles, artMCParticlesToMCTruth);
-
         LArPandoraHelper::CollectSimChannels(evt, m_simChannelModuleLabel, artSimChannels);
-        if (!artSimChannels.empty())
-        {
-            LArPandoraHelper::BuildMCParticleHitMaps(artHits, artSimChannels, artHitsToTrackIDEs);
-        }
-        else
+
+        if (artSimChannels.empty())
         {
             if (m_backtrackerModuleLabel.empty())
             {
@@ -204,38 +538,268 @@ void LArPandora::CreatePandoraInput(art::Event &evt, IdToHitMap &idToHitMap)
         }
     }
 
-    LArPandoraInput::CreatePandoraHits2D(m_inputSettings, m_driftVolumeMap, artHits, idToHitMap);
+    // The matching of hits to SimChannel deposits and the hit conversion only read the collected products and the providers fetched here,
+    // so may be run concurrently
+    const detinfo::DetectorClocks *const pDetectorClocks(lar::providerFrom<detinfo::DetectorClocksService>());
+
+    auto convertHits = [&]()
+    {
+        LArPandoraInstrumentation::ScopedTimer timer(pInstrumentation, LArPandoraInstrumentation::kInputHitConversion);
+        LArPandoraInput::FillHitBatch(m_detectorLookupTable, artHits, hitBatch);
+        LArPandoraInput::ConvertHitBatch(m_inputSettings, m_hitConversionConstants, hitBatch);
+        LArPandoraInput::FilterHitBatch(m_hitFilter, hitBatch, hitFilterCounters);
+    };
+
+    auto matchSimChannels = [&]()
+    {
+        LArPandoraInstrumentation::ScopedTimer timer(pInstrumentation, LArPandoraInstrumentation::kInputTruthCollection);
+
+        if (m_useSimChannelSweep)
+        {
+            LArPandoraHelper::BuildMCParticleHitTable(*pDetectorClocks, artHits, artSimChannels, artHitTrackIDETable);
+        }
+        else
+        {
+            LArPandoraHelper::BuildMCParticleHitMaps(*pDetectorClocks, artHits, artSimChannels, artHitsToTrackIDEs);
+        }
+    };
+
+    const bool shouldMatchSimChannels(shouldCollectTruth && !artSimChannels.empty());
+
+    if (shouldMatchSimChannels && m_enableConcurrentInput)
+    {
+        // ATTN The hit conversion stays on the module thread, as it may use the detector properties service for the Birks correction
+        tbb::task_group taskGroup;
+        taskGroup.run(matchSimChannels);
+        convertHits();
+        taskGroup.wait();
+    }
+    else
+    {
+        if (shouldMatchSimChannels)
+            matchSimChannels();
+
+        convertHits();
+    }
+
+    m_hitFilterCounters += hitFilterCounters;
+
+    if (hitFilterCounters.m_nAccepted != hitFilterCounters.m_nInput)
+    {
+        mf::LogDebug("LArPandora") << " LArPandora::CreatePandoraInput - hit filter rejected " << (hitFilterCounters.m_nInput - hitFilterCounters.m_nAccepted)
+                                   << " of " << hitFilterCounters.m_nInput << " hits (" << hitFilterCounters.m_nNonFinite << " non-finite) " << std::endl;
+    }
 
-    if (m_enableMCParticles && !evt.isRealData())
+    if (pInstrumentation)
     {
-        LArPandoraInput::CreatePandoraMCParticles(m_inputSettings, artMCTruthToMCParticles, artMCParticlesToMCTruth, generatorArtMCParticleVector);
-        LArPandoraInput::CreatePandoraMCLinks2D(m_inputSettings, idToHitMap, artHitsToTrackIDEs);
+        pInstrumentation->AddCount(LArPandoraInstrumentation::kNInputHits, hitFilterCounters.m_nInput);
+        pInstrumentation->AddCount(LArPandoraInstrumentation::kNPandoraHits, hitFilterCounters.m_nAccepted);
+    }
+
+    // Events exceeding the budget are registered with the fallback instance, or not at all
+    this->ApplyEventBudget(hitFilterCounters.m_nAccepted);
+
+    if (larpandoraobj::EventMetadata::kEmptyFallback == m_eventBudget.m_fallback)
+        return;
+
+    const LArPandoraInput::Settings &inputSettings((larpandoraobj::EventMetadata::kCosmicOnlyFallback == m_eventBudget.m_fallback) ?
+        m_fallbackInputSettings : m_inputSettings);
+
+    // ATTN The pools are shared by all replicas, so these counts also include any concurrent registration by other schedules
+    const LArObjectPool &caloHitPool(LArPooledCaloHit::GetPool()), &mcParticlePool(LArPooledMCParticle::GetPool());
+    const size_t nPoolAllocations(caloHitPool.GetNAllocations() + mcParticlePool.GetNAllocations());
+    const size_t nPoolChunkAllocations(caloHitPool.GetNChunkAllocations() + mcParticlePool.GetNChunkAllocations());
+
+    // ATTN Registration with the pandora instance must remain serial
+    LArPandoraInstrumentation::ScopedTimer registrationTimer(pInstrumentation, LArPandoraInstrumentation::kInputRegistration);
+    LArPandoraInput::CreatePandoraHits2D(inputSettings, hitBatch, idToHitMap);
+
+    if (shouldCollectTruth)
+    {
+        LArPandoraInput::CreatePandoraMCParticles(inputSettings, m_pDetectorGeometry->GetTpcGridIndex(), artMCTruthToMCParticles, artMCParticlesToMCTruth, generatorArtMCParticleVector);
+
+        if (!artSimChannels.empty() && m_useSimChannelSweep)
+        {
+            LArPandoraInput::CreatePandoraMCLinks2D(inputSettings, idToHitMap, artHitTrackIDETable);
+        }
+        else
+        {
+            LArPandoraInput::CreatePandoraMCLinks2D(inputSettings, idToHitMap, artHitsToTrackIDEs);
+        }
     }
 
     if (m_enableTriggerMCParticle && evt.isRealData())
     {
         LArPandoraHelper::TriggerInformation triggerInformation;
         LArPandoraHelper::CollectTriggerInformation(evt, triggerInformation);
-        LArPandoraInput::CreatePandoraTriggerMCParticle(m_inputSettings, triggerInformation);
+        LArPandoraInput::CreatePandoraTriggerMCParticle(inputSettings, triggerInformation);
+    }
+
+    if (pInstrumentation)
+    {
+        pInstrumentation->AddCount(LArPandoraInstrumentation::kNPoolAllocations,
+            caloHitPool.GetNAllocations() + mcParticlePool.GetNAllocations() - nPoolAllocations);
+        pInstrumentation->AddCount(LArPandoraInstrumentation::kNPoolChunkAllocations,
+            caloHitPool.GetNChunkAllocations() + mcParticlePool.GetNChunkAllocations() - nPoolChunkAllocations);
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandora::ProcessPandoraOutput(art::Event &evt, const IdToHitMap &idToHitMap)
+template <typename TProducer>
+void LArPandoraT<TProducer>::ProcessPandoraOutput(art::Event &evt, const IdToHitMap &idToHitMap)
 {
-    if (m_enableProduction)
+    if (!m_enableProduction)
+        return;
+
+    if (larpandoraobj::EventMetadata::kEmptyFallback == m_eventBudget.m_fallback)
     {
-        m_outputSettings.m_shouldProduceAllOutcomes = false;
-        LArPandoraOutput::ProduceArtOutput(m_outputSettings, idToHitMap, evt);
-        
+        LArPandoraOutput::ProduceEmptyArtOutput(m_outputSettings, "", evt);
+
         if (m_shouldProduceAllOutcomes)
-        {
-            m_outputSettings.m_shouldProduceAllOutcomes = true;
-            m_outputSettings.m_allOutcomesInstanceLabel = m_allOutcomesInstanceLabel;
-            LArPandoraOutput::ProduceArtOutput(m_outputSettings, idToHitMap, evt);
-        }
+            LArPandoraOutput::ProduceEmptyArtOutput(m_outputSettings, m_allOutcomesInstanceLabel, evt);
+    }
+    else if (larpandoraobj::EventMetadata::kCosmicOnlyFallback == m_eventBudget.m_fallback)
+    {
+        LArPandoraOutput::ProduceArtOutput(m_fallbackOutputSettings, idToHitMap, evt);
+
+        // ATTN The fallback steering has no slice reconstruction, so there are no outcomes other than the consolidated output
+        if (m_shouldProduceAllOutcomes)
+            LArPandoraOutput::ProduceEmptyArtOutput(m_outputSettings, m_allOutcomesInstanceLabel, evt);
+    }
+    else if (m_shouldProduceAllOutcomes)
+    {
+        // ATTN Produces both the consolidated and the all outcomes products, sharing the conversion work between them
+        LArPandoraOutput::ProduceCombinedArtOutput(m_outputSettings, idToHitMap, evt);
+    }
+    else
+    {
+        LArPandoraOutput::ProduceArtOutput(m_outputSettings, idToHitMap, evt);
+    }
+
+    if (m_enableEventBudget)
+    {
+        evt.put(std::unique_ptr<larpandoraobj::EventMetadata>(new larpandoraobj::EventMetadata(m_eventBudget.m_fallback, m_eventBudget.m_nHits,
+            m_eventBudget.m_isHitBudgetExceeded, m_eventBudget.m_isTimeBudgetExceeded, m_eventBudget.m_predictedSeconds, m_eventBudget.m_runSeconds)),
+            m_eventMetadataInstanceLabel);
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void LArPandoraT<TProducer>::ApplyEventBudget(const size_t nHits)
+{
+    m_eventBudget = EventBudget();
+    m_eventBudget.m_nHits = nHits;
+
+    if (!m_enableEventBudget)
+        return;
+
+    // ATTN Pandora cannot be interrupted, so the time is predicted from the mean cost per hit of the full reconstructions so far
+    if (m_budgetRunHits > 0)
+        m_eventBudget.m_predictedSeconds = static_cast<double>(nHits) * m_budgetRunSeconds / static_cast<double>(m_budgetRunHits);
+
+    m_eventBudget.m_isHitBudgetExceeded = ((m_maxEventHits > 0) && (nHits > m_maxEventHits));
+    m_eventBudget.m_isTimeBudgetExceeded = ((m_maxEventSeconds > 0.) && (m_eventBudget.m_predictedSeconds > m_maxEventSeconds));
+
+    if (!m_eventBudget.m_isHitBudgetExceeded && !m_eventBudget.m_isTimeBudgetExceeded)
+        return;
+
+    m_eventBudget.m_fallback = m_budgetFallback;
+    ++m_nBudgetFallbacks;
+
+    if (m_eventBudget.m_isHitBudgetExceeded)
+        ++m_nHitBudgetExceeded;
+
+    if (m_eventBudget.m_isTimeBudgetExceeded)
+        ++m_nTimeBudgetExceeded;
+
+    mf::LogWarning("LArPandora") << " LArPandora::ApplyEventBudget - event with " << nHits << " hits and predicted time " << m_eventBudget.m_predictedSeconds
+                                 << " s exceeds the reconstruction budget, using the "
+                                 << ((larpandoraobj::EventMetadata::kCosmicOnlyFallback == m_budgetFallback) ? "cosmic-only" : "empty") << " fallback " << std::endl;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void LArPandoraT<TProducer>::RecordEventRunTime(const double runSeconds)
+{
+    m_eventBudget.m_runSeconds = runSeconds;
+
+    if (!m_enableEventBudget || (larpandoraobj::EventMetadata::kNoFallback != m_eventBudget.m_fallback))
+        return;
+
+    m_budgetRunSeconds += runSeconds;
+    m_budgetRunHits += m_eventBudget.m_nHits;
+
+    if ((m_maxEventSeconds > 0.) && (runSeconds > m_maxEventSeconds))
+    {
+        ++m_nTimeBudgetOverruns;
+        mf::LogWarning("LArPandora") << " LArPandora::RecordEventRunTime - full reconstruction of " << m_eventBudget.m_nHits << " hits took " << runSeconds
+                                     << " s, beyond the time budget " << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void LArPandoraT<TProducer>::RecordSliceOccupancy() const
+{
+    pandora::PfoVector slicePfos;
+    LArPandoraOutput::GetPandoraSlices(m_pPrimaryPandora, slicePfos);
+
+    // ATTN The slice workers are absent if the corresponding reconstruction option is disabled, in which case no outcomes are counted
+    const pandora::Pandora *pSliceNuWorker(nullptr), *pSliceCRWorker(nullptr);
+    (void) LArPandoraOutput::GetPandoraInstance(m_pPrimaryPandora, "SliceNuWorker", pSliceNuWorker);
+    (void) LArPandoraOutput::GetPandoraInstance(m_pPrimaryPandora, "SliceCRWorker", pSliceCRWorker);
+
+    for (unsigned int sliceIndex = 0; sliceIndex < slicePfos.size(); ++sliceIndex)
+    {
+        unsigned int nHits(0);
+
+        for (const pandora::Cluster *const pCluster : slicePfos.at(sliceIndex)->GetClusterList())
+            nHits += pCluster->GetNCaloHits() + pCluster->GetNIsolatedCaloHits();
+
+        m_pInstrumentation->AddSliceOccupancy(nHits,
+            LArPandoraT::GetNPfos(pSliceNuWorker, "NeutrinoParticles3D" + std::to_string(sliceIndex)),
+            LArPandoraT::GetNPfos(pSliceCRWorker, "MuonParticles3D" + std::to_string(sliceIndex)));
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+unsigned int LArPandoraT<TProducer>::GetNPfos(const pandora::Pandora *const pPandora, const std::string &pfoListName)
+{
+    if (!pPandora)
+        return 0;
+
+    const pandora::PfoList *pPfoList(nullptr);
+
+    if (pandora::STATUS_CODE_SUCCESS != PandoraApi::GetPfoList(*pPandora, pfoListName, pPfoList))
+        return 0;
+
+    return pPfoList->size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+LArPandoraT<TProducer>::EventBudget::EventBudget() :
+    m_fallback(larpandoraobj::EventMetadata::kNoFallback),
+    m_nHits(0),
+    m_isHitBudgetExceeded(false),
+    m_isTimeBudgetExceeded(false),
+    m_predictedSeconds(0.),
+    m_runSeconds(0.)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template class LArPandoraT<art::EDProducer>;
+template class LArPandoraT<art::ReplicatedProducer>;
+
 } // namespace lar_pandora
@@ -12,30 +12,49 @@
 #include "larpandora/LArPandoraInterface/LArPandoraInput.h"
 #include "larpandora/LArPandoraInterface/LArPandoraOutput.h"
 #include "larpandora/LArPandoraInterface/LArPandoraGeometry.h"
+#include "larpandora/LArPandoraInterface/LArPandoraInstrumentation.h"
+
+#include "larpandora/LArPandoraObjects/EventMetadata.h"
+
+#include "larevt/CalibrationDBI/Interface/ChannelStatusProvider.h"
 
 #include <string>
-#include <memory> // std::unique_ptr<>
+#include <memory> // std::unique_ptr<>, std::shared_ptr<>
 
 namespace lar_pandora
 {
 
 /**
- *  @brief  LArPandora class
+ *  @brief  LArPandoraT class template, on top of art::EDProducer for the legacy LArPandora producers or art::ReplicatedProducer for the
+ *          replicated producers
  */
-class LArPandora : public ILArPandora
+template <typename TProducer>
+class LArPandoraT : public ILArPandoraT<TProducer>
 {
 public:
     /**
      *  @brief  Constructor
      *
      *  @param  pset the parameter set
+     *  @param  pFrame the address of the processing frame of the schedule that owns a replicated producer, nullptr for a legacy producer
      */
-    LArPandora(fhicl::ParameterSet const &pset);
+    LArPandoraT(fhicl::ParameterSet const &pset, const art::ProcessingFrame *const pFrame = nullptr);
 
     void beginJob();
+    void beginRun(art::Run &run);
+    void endJob();
     void produce(art::Event &evt);
 
+    // ATTN The replicated producers are called with the processing frame of their schedule, which is not needed here
+    void beginJob(art::ProcessingFrame const &frame);
+    void beginRun(art::Run &run, art::ProcessingFrame const &frame);
+    void endJob(art::ProcessingFrame const &frame);
+    void produce(art::Event &evt, art::ProcessingFrame const &frame);
+
 protected:
+    using ILArPandoraT<TProducer>::m_pPrimaryPandora;
+    using ILArPandoraT<TProducer>::m_pFallbackPandora;
+
     std::string                     m_configFile;                   ///< The config file
 
     bool                            m_shouldRunAllHitsCosmicReco;   ///< Steering: whether to run all hits cosmic-ray reconstruction
@@ -49,9 +68,83 @@ protected:
     bool                            m_printOverallRecoStatus;       ///< Steering: whether to print current operation status messages
 
 private:        
+    /**
+     *  @brief  EventBudget class, holding the outcome of the reconstruction budget for the current event
+     */
+    class EventBudget
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        EventBudget();
+
+        larpandoraobj::EventMetadata::Fallback m_fallback;      ///< The fallback used in place of the full reconstruction
+        unsigned int                m_nHits;                    ///< The number of hits passed to pandora
+        bool                        m_isHitBudgetExceeded;      ///< Whether the number of hits exceeded the budget
+        bool                        m_isTimeBudgetExceeded;     ///< Whether the predicted time of the full reconstruction exceeded the budget
+        double                      m_predictedSeconds;         ///< The predicted time of the full reconstruction (s), zero if no prediction
+        double                      m_runSeconds;               ///< The time spent running the pandora instances (s)
+    };
+
     void CreatePandoraInput(art::Event &evt, IdToHitMap &idToHitMap);
     void ProcessPandoraOutput(art::Event &evt, const IdToHitMap &idToHitMap);
 
+    /**
+     *  @brief  Decide whether the current event may run the full reconstruction or must use the fallback, given its number of hits
+     *
+     *  @param  nHits the number of hits passed to pandora
+     */
+    void ApplyEventBudget(const size_t nHits);
+
+    /**
+     *  @brief  Record the time spent running the pandora instances for the current event, updating the cost per hit of the full reconstruction
+     *
+     *  @param  runSeconds the time spent running the pandora instances (s)
+     */
+    void RecordEventRunTime(const double runSeconds);
+
+    /**
+     *  @brief  Record the slice occupancy of the current event: the numbers of hits and outcome particles of each pandora slice
+     */
+    void RecordSliceOccupancy() const;
+
+    /**
+     *  @brief  Get the number of particles in a named list of a pandora instance
+     *
+     *  @param  pPandora the address of the pandora instance, may be nullptr
+     *  @param  pfoListName the name of the particle list
+     *
+     *  @return the number of particles, zero if the instance or the list doesn't exist
+     */
+    static unsigned int GetNPfos(const pandora::Pandora *const pPandora, const std::string &pfoListName);
+
+    /**
+     *  @brief  Update the pandora line gaps and the hit filter bad channel veto, if the set of bad channels has changed. Called for each
+     *          event, as channel status providers backed by an interval-of-validity database only update per event
+     */
+    void UpdateBadChannels();
+
+    /**
+     *  @brief  Create pandora line gaps for any regions of bad channels not already covered
+     *
+     *  @param  badChannels the set of bad channels
+     *  @param  badChannelKey the key identifying the set of bad channels
+     */
+    void UpdateReadoutGaps(const lariov::ChannelStatusProvider::ChannelSet_t &badChannels, const size_t badChannelKey);
+
+    /**
+     *  @brief  Load the drift volume x ranges used by the hit filter
+     */
+    void LoadHitFilterDriftVolumes();
+
+    /**
+     *  @brief  Load the bad channels vetoed by the hit filter
+     *
+     *  @param  badChannels the set of bad channels
+     */
+    void LoadHitFilterBadChannels(const lariov::ChannelStatusProvider::ChannelSet_t &badChannels);
+
     std::string                     m_generatorModuleLabel;         ///< The generator module label
     std::string                     m_geantModuleLabel;             ///< The geant module label
     std::string                     m_simChannelModuleLabel;        ///< The SimChannel producer module label
@@ -59,19 +152,83 @@ private:
     std::string                     m_backtrackerModuleLabel;       ///< The back tracker module label
     
     std::string                     m_allOutcomesInstanceLabel;     ///< The instance label for all outcomes
+    std::string                     m_eventMetadataInstanceLabel;   ///< The instance label for the reconstruction budget event metadata
+    std::string                     m_readoutGapCacheFile;          ///< Optional file in which to cache the readout gaps for the current bad channels
 
     bool                            m_enableProduction;             ///< Whether to persist output products
     bool                            m_enableDetectorGaps;           ///< Whether to pass detector gap information to Pandora instances
     bool                            m_enableMCParticles;            ///< Whether to pass mc information to Pandora instances to aid development
     bool                            m_enableTriggerMCParticle;      ///< Allow creation of fake mc particle representing trigger information
-    bool                            m_lineGapsCreated;              ///< Book-keeping: whether line gap creation has been called
+    bool                            m_useSimChannelSweep;           ///< Whether to build hit truth links via a single time-ordered sweep of each SimChannel
+    bool                            m_enableConcurrentInput;        ///< Whether to prepare mc truth input concurrently with the hit conversion
+    bool                            m_badChannelsLoaded;            ///< Book-keeping: whether the line gaps and bad channel veto have been loaded
+    size_t                          m_badChannelKey;                ///< Book-keeping: key for the set of bad channels used to create line gaps and veto
+    size_t                          m_geometryKey;                  ///< Book-keeping: key for the detector geometry, validating the readout gap cache
 
     LArPandoraInput::Settings       m_inputSettings;                ///< The lar pandora input settings
     LArPandoraOutput::Settings      m_outputSettings;               ///< The lar pandora output settings
+    LArPandoraInput::HitConversionConstants m_hitConversionConstants; ///< The hit conversion constants, loaded at each run boundary
+    LArPandoraInput::HitFilter      m_hitFilter;                    ///< The cuts applied to the ART hits before they are passed to pandora
+    LArPandoraInput::HitFilterCounters m_hitFilterCounters;         ///< The numbers of hits rejected by the hit filter, summed over the job
+    double                          m_hitFilterDriftVolumeXMargin;  ///< The tolerance on the drift volume x range applied by the hit filter
+
+    std::shared_ptr<const LArDetectorGeometry> m_pDetectorGeometry; ///< The drift volumes, tpc grid index and detector gaps, shared by all producers
+    LArDetectorLookupTable          m_detectorLookupTable;          ///< The per-plane wire positions, wire pitches and tick to x conversions
+    LArReadoutGapList               m_readoutGapList;               ///< The readout gaps already passed to the pandora instance
+
+    std::unique_ptr<LArPandoraInstrumentation> m_pInstrumentation;  ///< The stage timing instrumentation, nullptr if disabled
+    bool                            m_instrumentSliceOccupancy;     ///< Whether the instrumentation records the slice occupancy
 
-    LArDriftVolumeMap               m_driftVolumeMap;               ///< The map from volume id to drift volume
+    unsigned int                    m_maxEventHits;                 ///< Budget: the maximum number of hits for the full reconstruction, zero for no limit
+    double                          m_maxEventSeconds;              ///< Budget: the maximum predicted time of the full reconstruction (s), zero for no limit
+    bool                            m_enableEventBudget;            ///< Budget: whether either limit is set
+    larpandoraobj::EventMetadata::Fallback m_budgetFallback;        ///< Budget: the fallback for events exceeding the budget
+    LArPandoraInput::Settings       m_fallbackInputSettings;        ///< The lar pandora input settings for the fallback pandora instance
+    LArPandoraOutput::Settings      m_fallbackOutputSettings;       ///< The lar pandora output settings for the fallback pandora instance
+    EventBudget                     m_eventBudget;                  ///< The outcome of the reconstruction budget for the current event
+    double                          m_budgetRunSeconds;             ///< Book-keeping: the time spent in the full reconstruction, summed over the job (s)
+    size_t                          m_budgetRunHits;                ///< Book-keeping: the hits passed to the full reconstruction, summed over the job
+    size_t                          m_nBudgetFallbacks;             ///< Book-keeping: the number of events for which the fallback was used
+    size_t                          m_nHitBudgetExceeded;           ///< Book-keeping: the number of events exceeding the hit budget
+    size_t                          m_nTimeBudgetExceeded;          ///< Book-keeping: the number of events whose predicted time exceeded the budget
+    size_t                          m_nTimeBudgetOverruns;          ///< Book-keeping: the number of full reconstructions that ran beyond the time budget
 };
 
+typedef LArPandoraT<art::EDProducer> LArPandora;
+typedef LArPandoraT<art::ReplicatedProducer> ReplicatedLArPandora;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+inline void LArPandoraT<TProducer>::beginJob(art::ProcessingFrame const &/*frame*/)
+{
+    this->beginJob();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+inline void LArPandoraT<TProducer>::beginRun(art::Run &run, art::ProcessingFrame const &/*frame*/)
+{
+    this->beginRun(run);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+inline void LArPandoraT<TProducer>::endJob(art::ProcessingFrame const &/*frame*/)
+{
+    this->endJob();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+inline void LArPandoraT<TProducer>::produce(art::Event &evt, art::ProcessingFrame const &/*frame*/)
+{
+    this->produce(evt);
+}
+
 } // namespace lar_pandora
 
 #endif // #ifndef LAR_PANDORA_H
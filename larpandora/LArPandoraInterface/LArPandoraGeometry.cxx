@@ -5,15 +5,23 @@
  */
 
 #include "cetlib_except/exception.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
 
 #include "larcore/Geometry/Geometry.h"
 #include "larcorealg/Geometry/TPCGeo.h"
 #include "larcorealg/Geometry/PlaneGeo.h"
 #include "larcorealg/Geometry/WireGeo.h"
 
+#include "lardata/DetectorInfoServices/DetectorPropertiesService.h"
+
 #include "larpandora/LArPandoraInterface/LArPandoraGeometry.h"
 
+#include <cmath>
+#include <fstream>
+#include <functional>
 #include <iomanip>
+#include <limits>
+#include <mutex>
 #include <set>
 #include <sstream>
 
@@ -71,6 +79,18 @@ void LArPandoraGeometry::LoadDetectorGaps(LArDetectorGapList &listOfGaps)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+std::shared_ptr<const LArDetectorGeometry> LArPandoraGeometry::GetDetectorGeometry()
+{
+    // ATTN Loaded under std::call_once, so that concurrent first calls wait for a single load; the geometry is never modified afterwards
+    static std::once_flag loadFlag;
+    static std::shared_ptr<const LArDetectorGeometry> pDetectorGeometry;
+    std::call_once(loadFlag, []() {pDetectorGeometry = std::make_shared<const LArDetectorGeometry>();});
+
+    return pDetectorGeometry;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 void LArPandoraGeometry::LoadGeometry(LArDriftVolumeList &outputVolumeList, LArDriftVolumeMap &outputVolumeMap)
 {
     if (!outputVolumeList.empty())
@@ -93,17 +113,245 @@ void LArPandoraGeometry::LoadGeometry(LArDriftVolumeList &outputVolumeList, LArD
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-unsigned int LArPandoraGeometry::GetVolumeID(const LArDriftVolumeMap &driftVolumeMap, const unsigned int cstat, const unsigned int tpc)
+void LArPandoraGeometry::LoadDetectorLookupTable(const LArDriftVolumeMap &driftVolumeMap, LArDetectorLookupTable &lookupTable)
 {
     if (driftVolumeMap.empty())
-        throw cet::exception("LArPandora") << " LArPandoraGeometry::GetVolumeID --- detector geometry map is empty";
+        throw cet::exception("LArPandora") << " LArPandoraGeometry::LoadDetectorLookupTable --- detector geometry map is empty";
+
+    art::ServiceHandle<geo::Geometry> theGeometry;
+    auto const *theDetector = lar::providerFrom<detinfo::DetectorPropertiesService>();
+
+    // Flatten the cryostat/tpc numbering, so that each plane can be reached via a single array index
+    std::vector<unsigned int> tpcOffsets;
+    unsigned int nTpcs(0), maxPlanes(0);
+
+    for (unsigned int icstat = 0; icstat < theGeometry->Ncryostats(); ++icstat)
+    {
+        tpcOffsets.push_back(nTpcs);
+        nTpcs += theGeometry->NTPC(icstat);
+
+        for (unsigned int itpc = 0; itpc < theGeometry->NTPC(icstat); ++itpc)
+            maxPlanes = std::max(maxPlanes, theGeometry->Nplanes(itpc, icstat));
+    }
+
+    tpcOffsets.push_back(nTpcs);
+
+    LArPlaneLookupList planeList;
+    planeList.reserve(nTpcs * maxPlanes);
+
+    for (unsigned int icstat = 0; icstat < theGeometry->Ncryostats(); ++icstat)
+    {
+        for (unsigned int itpc = 0; itpc < theGeometry->NTPC(icstat); ++itpc)
+        {
+            const unsigned int volumeID(LArPandoraGeometry::GetVolumeID(driftVolumeMap, icstat, itpc));
+            const unsigned int nPlanes(theGeometry->Nplanes(itpc, icstat));
+
+            for (unsigned int iplane = 0; iplane < maxPlanes; ++iplane)
+            {
+                // Pad tpcs with fewer planes than the maximum, so that the indexing remains regular
+                if (iplane >= nPlanes)
+                {
+                    planeList.push_back(LArPlaneLookup(geo::kUnknown, geo::kUnknown, volumeID, 0.f, 0., 0., std::vector<double>(), std::vector<double>()));
+                    continue;
+                }
+
+                const geo::PlaneGeo &thePlane(theGeometry->Plane(iplane, itpc, icstat));
+                const geo::View_t view(thePlane.View());
+
+                std::vector<double> wireCenterY, wireCenterZ;
+                wireCenterY.reserve(thePlane.Nwires());
+                wireCenterZ.reserve(thePlane.Nwires());
+
+                for (unsigned int iwire = 0; iwire < thePlane.Nwires(); ++iwire)
+                {
+                    double xyz[3] = {0., 0., 0.};
+                    thePlane.Wire(iwire).GetCenter(xyz);
+                    wireCenterY.push_back(xyz[1]);
+                    wireCenterZ.push_back(xyz[2]);
+                }
+
+                // The conversion from ticks to x is linear within a given plane
+                const double tickToXOffset(theDetector->ConvertTicksToX(0., iplane, itpc, icstat));
+                const double tickToXSlope(theDetector->ConvertTicksToX(1., iplane, itpc, icstat) - tickToXOffset);
+
+                // Wire pitches can differ between tpcs, so take the pitch of this plane, unless it has too few wires to define one
+                const float wirePitch((thePlane.Nwires() > 1) ? thePlane.WirePitch() : theGeometry->WirePitch(view));
+
+                planeList.push_back(LArPlaneLookup(view, LArPandoraGeometry::GetGlobalView(icstat, itpc, view), volumeID, wirePitch,
+                    tickToXOffset, tickToXSlope, wireCenterY, wireCenterZ));
+            }
+        }
+    }
+
+    lookupTable = LArDetectorLookupTable(tpcOffsets, maxPlanes, planeList);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraGeometry::LoadTpcGridIndex(LArTpcGridIndex &tpcGridIndex)
+{
+    art::ServiceHandle<geo::Geometry> theGeometry;
+    LArTpcBoxList tpcBoxList;
+
+    for (unsigned int icstat = 0; icstat < theGeometry->Ncryostats(); ++icstat)
+    {
+        for (unsigned int itpc = 0; itpc < theGeometry->NTPC(icstat); ++itpc)
+        {
+            const geo::TPCGeo &theTpc(theGeometry->TPC(itpc, icstat));
+            tpcBoxList.push_back(LArTpcBox(icstat, itpc, (theTpc.DriftDirection() == geo::kNegX), theTpc.MinX(), theTpc.MinY(), theTpc.MinZ(),
+                theTpc.MaxX(), theTpc.MaxY(), theTpc.MaxZ()));
+        }
+    }
+
+    if (tpcBoxList.empty())
+        throw cet::exception("LArPandora") << " LArPandoraGeometry::LoadTpcGridIndex --- failed to find any tpcs in this detector geometry ";
+
+    tpcGridIndex = LArTpcGridIndex(tpcBoxList);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraGeometry::LoadReadoutGaps(const std::set<raw::ChannelID_t> &badChannels, LArReadoutGapList &readoutGapList)
+{
+    if (!readoutGapList.empty())
+        throw cet::exception("LArPandora") << " LArPandoraGeometry::LoadReadoutGaps --- the list of readout gaps already exists ";
+
+    art::ServiceHandle<geo::Geometry> theGeometry;
+
+    // Map each bad channel to its wire(s), then identify the continuous runs of bad wires in each plane
+    std::map<geo::PlaneID, std::set<unsigned int> > planeToBadWires;
+
+    for (const raw::ChannelID_t channel : badChannels)
+    {
+        for (const geo::WireID &wireID : theGeometry->ChannelToWire(channel))
+            (void) planeToBadWires[wireID.planeID()].insert(wireID.Wire);
+    }
+
+    for (const auto &planeEntry : planeToBadWires)
+    {
+        const geo::PlaneID &planeID(planeEntry.first);
+        std::set<unsigned int>::const_iterator iter(planeEntry.second.begin());
+
+        while (planeEntry.second.end() != iter)
+        {
+            const unsigned int firstWire(*iter);
+            unsigned int lastWire(firstWire);
+
+            while ((planeEntry.second.end() != ++iter) && (*iter == lastWire + 1))
+                lastWire = *iter;
+
+            readoutGapList.push_back(LArReadoutGap(planeID.Cryostat, planeID.TPC, planeID.Plane, firstWire, lastWire));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+size_t LArPandoraGeometry::GetBadChannelKey(const std::set<raw::ChannelID_t> &badChannels)
+{
+    size_t key(std::hash<size_t>()(badChannels.size()));
+
+    for (const raw::ChannelID_t channel : badChannels)
+        key ^= std::hash<raw::ChannelID_t>()(channel) + 0x9e3779b9 + (key << 6) + (key >> 2);
+
+    return key;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+size_t LArPandoraGeometry::GetGeometryKey()
+{
+    art::ServiceHandle<geo::Geometry> theGeometry;
+
+    size_t key(std::hash<std::string>()(theGeometry->DetectorName()));
+    key ^= std::hash<std::string>()(theGeometry->GDMLFile()) + 0x9e3779b9 + (key << 6) + (key >> 2);
+    key ^= std::hash<unsigned int>()(theGeometry->Nchannels()) + 0x9e3779b9 + (key << 6) + (key >> 2);
+
+    for (unsigned int icstat = 0; icstat < theGeometry->Ncryostats(); ++icstat)
+        key ^= std::hash<unsigned int>()(theGeometry->NTPC(icstat)) + 0x9e3779b9 + (key << 6) + (key >> 2);
+
+    return key;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool LArPandoraGeometry::ReadReadoutGaps(const std::string &fileName, const size_t geometryKey, const size_t badChannelKey,
+    LArReadoutGapList &readoutGapList)
+{
+    if (!readoutGapList.empty())
+        throw cet::exception("LArPandora") << " LArPandoraGeometry::ReadReadoutGaps --- the list of readout gaps already exists ";
+
+    std::ifstream inputFile(fileName);
+
+    if (!inputFile.good())
+        return false;
+
+    std::string header;
+    size_t fileGeometryKey(0), fileBadChannelKey(0), nGaps(0);
+
+    if (!(inputFile >> header >> fileGeometryKey >> fileBadChannelKey >> nGaps) || (header != "LArPandoraReadoutGaps") ||
+        (fileGeometryKey != geometryKey) || (fileBadChannelKey != badChannelKey))
+    {
+        return false;
+    }
+
+    unsigned int cstat(0), tpc(0), plane(0), firstWire(0), lastWire(0);
+
+    while (inputFile >> cstat >> tpc >> plane >> firstWire >> lastWire)
+        readoutGapList.push_back(LArReadoutGap(cstat, tpc, plane, firstWire, lastWire));
+
+    if (readoutGapList.size() != nGaps)
+    {
+        readoutGapList.clear();
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraGeometry::WriteReadoutGaps(const std::string &fileName, const size_t geometryKey, const size_t badChannelKey,
+    const LArReadoutGapList &readoutGapList)
+{
+    std::ofstream outputFile(fileName);
+
+    // ATTN The cache is optional, so a file that can't be written leaves the readout gaps, already computed, in use
+    if (!outputFile.good())
+    {
+        mf::LogWarning("LArPandora") << " LArPandoraGeometry::WriteReadoutGaps - unable to open file " << fileName << ", readout gaps not cached " << std::endl;
+        return;
+    }
+
+    outputFile << "LArPandoraReadoutGaps " << geometryKey << " " << badChannelKey << " " << readoutGapList.size() << std::endl;
+
+    for (const LArReadoutGap &gap : readoutGapList)
+    {
+        outputFile << gap.GetCryostat() << " " << gap.GetTpc() << " " << gap.GetPlane() << " " << gap.GetFirstWire() << " "
+                   << gap.GetLastWire() << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const LArDriftVolume &LArPandoraGeometry::GetDriftVolume(const LArDriftVolumeMap &driftVolumeMap, const unsigned int cstat, const unsigned int tpc)
+{
+    if (driftVolumeMap.empty())
+        throw cet::exception("LArPandora") << " LArPandoraGeometry::GetDriftVolume --- detector geometry map is empty";
 
     LArDriftVolumeMap::const_iterator iter = driftVolumeMap.find(LArPandoraGeometry::GetTpcID(cstat, tpc));
 
     if (driftVolumeMap.end() == iter)
-        throw cet::exception("LArPandora") << " LArPandoraGeometry::GetVolumeID --- found a TPC that doesn't belong to a drift volume";
+        throw cet::exception("LArPandora") << " LArPandoraGeometry::GetDriftVolume --- found a TPC that doesn't belong to a drift volume";
 
-    return iter->second.GetVolumeID();
+    return iter->second;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+unsigned int LArPandoraGeometry::GetVolumeID(const LArDriftVolumeMap &driftVolumeMap, const unsigned int cstat, const unsigned int tpc)
+{
+    return LArPandoraGeometry::GetDriftVolume(driftVolumeMap, cstat, tpc).GetVolumeID();
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -370,4 +618,151 @@ const LArDaughterDriftVolumeList &LArDriftVolume::GetTpcVolumeList() const
     return m_tpcVolumeList;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArTpcBox::LArTpcBox(const unsigned int cryostat, const unsigned int tpc, const bool isNegativeDrift, const double minX, const double minY,
+        const double minZ, const double maxX, const double maxY, const double maxZ) :
+    m_cryostat(cryostat),
+    m_tpc(tpc),
+    m_isNegativeDrift(isNegativeDrift),
+    m_min{std::min(minX, maxX), std::min(minY, maxY), std::min(minZ, maxZ)},
+    m_max{std::max(minX, maxX), std::max(minY, maxY), std::max(minZ, maxZ)}
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArTpcGridIndex::LArTpcGridIndex() :
+    m_origin{0., 0., 0.},
+    m_cellSize{1., 1., 1.},
+    m_nCells{0, 0, 0}
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArTpcGridIndex::LArTpcGridIndex(const LArTpcBoxList &tpcBoxList) :
+    m_tpcBoxList(tpcBoxList),
+    m_origin{0., 0., 0.},
+    m_cellSize{1., 1., 1.},
+    m_nCells{1, 1, 1}
+{
+    if (m_tpcBoxList.empty())
+        throw cet::exception("LArPandora") << " LArTpcGridIndex::LArTpcGridIndex --- no tpc boxes provided ";
+
+    // Size the cells using the smallest tpc extent along each axis, so that each cell overlaps only a handful of tpcs
+    const unsigned int maxCellsPerAxis(256);
+
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        double minCoordinate(std::numeric_limits<double>::max()), maxCoordinate(-std::numeric_limits<double>::max());
+        double minExtent(std::numeric_limits<double>::max());
+
+        for (const LArTpcBox &tpcBox : m_tpcBoxList)
+        {
+            minCoordinate = std::min(minCoordinate, tpcBox.GetMin(axis));
+            maxCoordinate = std::max(maxCoordinate, tpcBox.GetMax(axis));
+
+            if (tpcBox.GetMax(axis) > tpcBox.GetMin(axis))
+                minExtent = std::min(minExtent, tpcBox.GetMax(axis) - tpcBox.GetMin(axis));
+        }
+
+        const double totalExtent(maxCoordinate - minCoordinate);
+        m_origin[axis] = minCoordinate;
+
+        if (!(totalExtent > 0.) || (minExtent > totalExtent))
+            continue;
+
+        m_cellSize[axis] = std::max(minExtent, totalExtent / static_cast<double>(maxCellsPerAxis));
+        m_nCells[axis] = std::max(1u, std::min(maxCellsPerAxis, static_cast<unsigned int>(std::ceil(totalExtent / m_cellSize[axis]))));
+    }
+
+    // Store the tpc boxes overlapping each cell, in compressed form
+    const unsigned int nCellsTotal(m_nCells[0] * m_nCells[1] * m_nCells[2]);
+    std::vector<std::vector<unsigned int> > cellToBoxes(nCellsTotal);
+
+    for (unsigned int iBox = 0; iBox < m_tpcBoxList.size(); ++iBox)
+    {
+        const LArTpcBox &tpcBox(m_tpcBoxList[iBox]);
+        unsigned int lowIndex[3] = {0, 0, 0}, highIndex[3] = {0, 0, 0};
+
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            // ATTN Small tolerance, so that positions on a tpc boundary are never assigned to a cell that misses the tpc
+            const double lowOffset((tpcBox.GetMin(axis) - m_origin[axis]) / m_cellSize[axis] - 1.e-6);
+            const double highOffset((tpcBox.GetMax(axis) - m_origin[axis]) / m_cellSize[axis] + 1.e-6);
+            lowIndex[axis] = std::min(static_cast<unsigned int>(std::max(0., lowOffset)), m_nCells[axis] - 1);
+            highIndex[axis] = std::min(static_cast<unsigned int>(std::max(0., highOffset)), m_nCells[axis] - 1);
+        }
+
+        for (unsigned int ix = lowIndex[0]; ix <= highIndex[0]; ++ix)
+        {
+            for (unsigned int iy = lowIndex[1]; iy <= highIndex[1]; ++iy)
+            {
+                for (unsigned int iz = lowIndex[2]; iz <= highIndex[2]; ++iz)
+                    cellToBoxes[(ix * m_nCells[1] + iy) * m_nCells[2] + iz].push_back(iBox);
+            }
+        }
+    }
+
+    m_cellOffsets.reserve(nCellsTotal + 1);
+
+    for (const std::vector<unsigned int> &boxes : cellToBoxes)
+    {
+        m_cellOffsets.push_back(m_cellEntries.size());
+        m_cellEntries.insert(m_cellEntries.end(), boxes.begin(), boxes.end());
+    }
+
+    m_cellOffsets.push_back(m_cellEntries.size());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArPlaneLookup::LArPlaneLookup(const geo::View_t view, const geo::View_t globalView, const unsigned int volumeID, const float wirePitch,
+        const double tickToXOffset, const double tickToXSlope, const std::vector<double> &wireCenterY, const std::vector<double> &wireCenterZ) :
+    m_view(view),
+    m_globalView(globalView),
+    m_volumeID(volumeID),
+    m_wirePitch(wirePitch),
+    m_tickToXOffset(tickToXOffset),
+    m_tickToXSlope(tickToXSlope),
+    m_wireCenterY(wireCenterY),
+    m_wireCenterZ(wireCenterZ)
+{
+    if (m_wireCenterY.size() != m_wireCenterZ.size())
+        throw cet::exception("LArPandora") << " LArPlaneLookup::LArPlaneLookup --- inconsistent numbers of wire positions ";
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArDetectorLookupTable::LArDetectorLookupTable() :
+    m_maxPlanes(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArDetectorLookupTable::LArDetectorLookupTable(const std::vector<unsigned int> &tpcOffsets, const unsigned int maxPlanes, const LArPlaneLookupList &planeList) :
+    m_tpcOffsets(tpcOffsets),
+    m_maxPlanes(maxPlanes),
+    m_planeList(planeList)
+{
+    if (m_tpcOffsets.empty() || (m_tpcOffsets.back() * m_maxPlanes != m_planeList.size()))
+        throw cet::exception("LArPandora") << " LArDetectorLookupTable::LArDetectorLookupTable --- inconsistent lookup table dimensions ";
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArDetectorGeometry::LArDetectorGeometry()
+{
+    LArPandoraGeometry::LoadGeometry(m_driftVolumeList, m_driftVolumeMap);
+    LArPandoraGeometry::LoadTpcGridIndex(m_tpcGridIndex);
+    LArPandoraGeometry::LoadDetectorGaps(m_detectorGapList);
+}
+
 } // namespace lar_pandora
@@ -7,7 +7,15 @@
 #ifndef LAR_PANDORA_GEOMETRY_H
 #define LAR_PANDORA_GEOMETRY_H 1
 
+#include "cetlib_except/exception.h"
+
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h"
+
+#include <algorithm>
 #include <map>
+#include <memory>
+#include <set>
+#include <string>
 #include <vector>
 
 namespace lar_pandora
@@ -248,6 +256,365 @@ typedef std::map<unsigned int, LArDriftVolume> LArDriftVolumeMap;
 //------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+/**
+ *  @brief  plane lookup class to hold precomputed readout properties of a single wire plane
+ */
+class LArPlaneLookup
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  view             the view of the plane
+     *  @param  globalView       the view of the plane in the pandora global coordinate system
+     *  @param  volumeID         the id of the drift volume containing the plane
+     *  @param  wirePitch        the wire pitch of the plane
+     *  @param  tickToXOffset    x coordinate corresponding to tick zero
+     *  @param  tickToXSlope     change in x coordinate per tick
+     *  @param  wireCenterY      y coordinate of the centre of each wire
+     *  @param  wireCenterZ      z coordinate of the centre of each wire
+     */
+    LArPlaneLookup(const geo::View_t view, const geo::View_t globalView, const unsigned int volumeID, const float wirePitch,
+        const double tickToXOffset, const double tickToXSlope, const std::vector<double> &wireCenterY, const std::vector<double> &wireCenterZ);
+
+    /**
+     *  @brief Return the view of the plane
+     */
+    geo::View_t GetView() const;
+
+    /**
+     *  @brief Return the view of the plane in the pandora global coordinate system
+     */
+    geo::View_t GetGlobalView() const;
+
+    /**
+     *  @brief Return the id of the drift volume containing the plane
+     */
+    unsigned int GetVolumeID() const;
+
+    /**
+     *  @brief Return the wire pitch of the plane
+     */
+    float GetWirePitch() const;
+
+    /**
+     *  @brief Return the x coordinate corresponding to tick zero
+     */
+    double GetTickToXOffset() const;
+
+    /**
+     *  @brief Return the change in x coordinate per tick
+     */
+    double GetTickToXSlope() const;
+
+    /**
+     *  @brief Return the number of wires in the plane
+     */
+    unsigned int GetNWires() const;
+
+    /**
+     *  @brief Convert a time in ticks to an x coordinate
+     *
+     *  @param ticks the input time in ticks
+     */
+    double ConvertTicksToX(const double ticks) const;
+
+    /**
+     *  @brief Return the y coordinate of the centre of a given wire
+     *
+     *  @param wire the wire number
+     */
+    double GetWireCenterY(const unsigned int wire) const;
+
+    /**
+     *  @brief Return the z coordinate of the centre of a given wire
+     *
+     *  @param wire the wire number
+     */
+    double GetWireCenterZ(const unsigned int wire) const;
+
+private:
+    geo::View_t         m_view;
+    geo::View_t         m_globalView;
+    unsigned int        m_volumeID;
+    float               m_wirePitch;
+    double              m_tickToXOffset;
+    double              m_tickToXSlope;
+    std::vector<double> m_wireCenterY;
+    std::vector<double> m_wireCenterZ;
+};
+
+typedef std::vector<LArPlaneLookup> LArPlaneLookupList;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  detector lookup table class to provide array-indexed access to per cryostat/tpc/plane readout properties
+ */
+class LArDetectorLookupTable
+{
+public:
+    /**
+     *  @brief  Default constructor, providing an empty table
+     */
+    LArDetectorLookupTable();
+
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  tpcOffsets   the index of the first tpc of each cryostat in the flattened tpc numbering, followed by the total number of tpcs
+     *  @param  maxPlanes    the maximum number of planes in any tpc
+     *  @param  planeList    the list of planes, indexed by (flattened tpc index * maxPlanes + plane)
+     */
+    LArDetectorLookupTable(const std::vector<unsigned int> &tpcOffsets, const unsigned int maxPlanes, const LArPlaneLookupList &planeList);
+
+    /**
+     *  @brief Whether the table has been populated
+     */
+    bool IsEmpty() const;
+
+    /**
+     *  @brief Return the lookup for a given cryostat, tpc and plane
+     *
+     *  @param cstat the cryostat
+     *  @param tpc the tpc
+     *  @param plane the plane
+     */
+    const LArPlaneLookup &GetPlane(const unsigned int cstat, const unsigned int tpc, const unsigned int plane) const;
+
+private:
+    std::vector<unsigned int>   m_tpcOffsets;
+    unsigned int                m_maxPlanes;
+    LArPlaneLookupList          m_planeList;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  tpc box class to hold the axis-aligned bounding box and drift direction of a single tpc
+ */
+class LArTpcBox
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  cryostat          the cryostat
+     *  @param  tpc               the tpc
+     *  @param  isNegativeDrift   whether the drift direction is towards negative x
+     *  @param  minX              lower X coordinate
+     *  @param  minY              lower Y coordinate
+     *  @param  minZ              lower Z coordinate
+     *  @param  maxX              upper X coordinate
+     *  @param  maxY              upper Y coordinate
+     *  @param  maxZ              upper Z coordinate
+     */
+    LArTpcBox(const unsigned int cryostat, const unsigned int tpc, const bool isNegativeDrift, const double minX, const double minY,
+        const double minZ, const double maxX, const double maxY, const double maxZ);
+
+    /**
+     *  @brief Return the cryostat
+     */
+    unsigned int GetCryostat() const;
+
+    /**
+     *  @brief Return the tpc
+     */
+    unsigned int GetTpc() const;
+
+    /**
+     *  @brief Return whether the drift direction is towards negative x
+     */
+    bool IsNegativeDrift() const;
+
+    /**
+     *  @brief Return the lower coordinate along a given axis (0 = x, 1 = y, 2 = z)
+     *
+     *  @param axis the axis
+     */
+    double GetMin(const unsigned int axis) const;
+
+    /**
+     *  @brief Return the upper coordinate along a given axis (0 = x, 1 = y, 2 = z)
+     *
+     *  @param axis the axis
+     */
+    double GetMax(const unsigned int axis) const;
+
+    /**
+     *  @brief Whether a position lies within the box (boundaries included)
+     *
+     *  @param x the x coordinate
+     *  @param y the y coordinate
+     *  @param z the z coordinate
+     */
+    bool Contains(const double x, const double y, const double z) const;
+
+private:
+    unsigned int    m_cryostat;
+    unsigned int    m_tpc;
+    bool            m_isNegativeDrift;
+    double          m_min[3];
+    double          m_max[3];
+};
+
+typedef std::vector<LArTpcBox> LArTpcBoxList;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  tpc grid index class, dividing the detector into a uniform grid of cells, each listing the tpcs whose boxes overlap it
+ */
+class LArTpcGridIndex
+{
+public:
+    /**
+     *  @brief  Default constructor, providing an empty index
+     */
+    LArTpcGridIndex();
+
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  tpcBoxList   the list of tpc boxes
+     */
+    LArTpcGridIndex(const LArTpcBoxList &tpcBoxList);
+
+    /**
+     *  @brief Whether the index has been populated
+     */
+    bool IsEmpty() const;
+
+    /**
+     *  @brief Find the tpc containing a given position
+     *
+     *  @param x the x coordinate
+     *  @param y the y coordinate
+     *  @param z the z coordinate
+     *
+     *  @return the address of the tpc box, or nullptr if the position is not within any tpc
+     */
+    const LArTpcBox *FindTpc(const double x, const double y, const double z) const;
+
+private:
+    LArTpcBoxList               m_tpcBoxList;       ///< The list of tpc boxes
+    double                      m_origin[3];        ///< The lower corner of the grid
+    double                      m_cellSize[3];      ///< The size of each cell along each axis
+    unsigned int                m_nCells[3];        ///< The number of cells along each axis
+    std::vector<unsigned int>   m_cellOffsets;      ///< The index of the first entry for each cell in m_cellEntries, followed by the total
+    std::vector<unsigned int>   m_cellEntries;      ///< The indices of the tpc boxes overlapping each cell
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  readout gap class to hold a continuous region of bad wires within a single plane
+ */
+class LArReadoutGap
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  cryostat   the cryostat
+     *  @param  tpc        the tpc
+     *  @param  plane      the plane
+     *  @param  firstWire  the first bad wire
+     *  @param  lastWire   the last bad wire
+     */
+    LArReadoutGap(const unsigned int cryostat, const unsigned int tpc, const unsigned int plane, const unsigned int firstWire, const unsigned int lastWire);
+
+    /**
+     *  @brief Return the cryostat
+     */
+    unsigned int GetCryostat() const;
+
+    /**
+     *  @brief Return the tpc
+     */
+    unsigned int GetTpc() const;
+
+    /**
+     *  @brief Return the plane
+     */
+    unsigned int GetPlane() const;
+
+    /**
+     *  @brief Return the first bad wire
+     */
+    unsigned int GetFirstWire() const;
+
+    /**
+     *  @brief Return the last bad wire
+     */
+    unsigned int GetLastWire() const;
+
+    /**
+     *  @brief Ordering operator, by cryostat, tpc, plane, first wire and last wire
+     *
+     *  @param rhs the readout gap to compare with
+     */
+    bool operator<(const LArReadoutGap &rhs) const;
+
+private:
+    unsigned int    m_cryostat;
+    unsigned int    m_tpc;
+    unsigned int    m_plane;
+    unsigned int    m_firstWire;
+    unsigned int    m_lastWire;
+};
+
+typedef std::vector<LArReadoutGap> LArReadoutGapList;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  detector geometry class, holding the geometry information that depends only upon the detector description. It is loaded once
+ *          per job and then shared, read-only, by all producers and schedules
+ */
+class LArDetectorGeometry
+{
+public:
+    /**
+     *  @brief  Constructor, loading the geometry from the geometry service
+     */
+    LArDetectorGeometry();
+
+    /**
+     *  @brief Return the list of drift volumes
+     */
+    const LArDriftVolumeList &GetDriftVolumeList() const;
+
+    /**
+     *  @brief Return the mapping between cryostat/tpc and drift volumes
+     */
+    const LArDriftVolumeMap &GetDriftVolumeMap() const;
+
+    /**
+     *  @brief Return the grid index of tpc bounding boxes
+     */
+    const LArTpcGridIndex &GetTpcGridIndex() const;
+
+    /**
+     *  @brief Return the list of 2D gaps between drift volumes
+     */
+    const LArDetectorGapList &GetDetectorGapList() const;
+
+private:
+    LArDriftVolumeList          m_driftVolumeList;      ///< The list of drift volumes
+    LArDriftVolumeMap           m_driftVolumeMap;       ///< The mapping between cryostat/tpc and drift volumes
+    LArTpcGridIndex             m_tpcGridIndex;         ///< The grid index of tpc bounding boxes
+    LArDetectorGapList          m_detectorGapList;      ///< The list of 2D gaps between drift volumes
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  LArPandoraGeometry class
  */
@@ -261,6 +628,13 @@ public:
      */
     static void LoadDetectorGaps(LArDetectorGapList &listOfGaps);
 
+    /**
+     *  @brief Get the detector geometry, loading it upon the first call. Subsequent calls, from any thread, return the same instance
+     *
+     *  @return the detector geometry
+     */
+    static std::shared_ptr<const LArDetectorGeometry> GetDetectorGeometry();
+
     /**
      *  @brief Load drift volume geometry
      *
@@ -269,6 +643,72 @@ public:
      */
     static void LoadGeometry(LArDriftVolumeList &outputVolumeList, LArDriftVolumeMap &outputVolumeMap);
 
+    /**
+     *  @brief Load the per-plane lookup table of wire positions, wire pitches and tick to x conversions
+     *
+     *  @param driftVolumeMap the mapping between cryostat/tpc and drift volumes
+     *  @param lookupTable the output lookup table
+     */
+    static void LoadDetectorLookupTable(const LArDriftVolumeMap &driftVolumeMap, LArDetectorLookupTable &lookupTable);
+
+    /**
+     *  @brief Load the grid index of tpc bounding boxes, used to locate positions within the detector
+     *
+     *  @param tpcGridIndex the output tpc grid index
+     */
+    static void LoadTpcGridIndex(LArTpcGridIndex &tpcGridIndex);
+
+    /**
+     *  @brief Load the continuous regions of bad wires, using only the (typically small) set of bad channels
+     *
+     *  @param badChannels the set of bad channels
+     *  @param readoutGapList the output list of readout gaps, ordered by cryostat, tpc, plane and wire
+     */
+    static void LoadReadoutGaps(const std::set<raw::ChannelID_t> &badChannels, LArReadoutGapList &readoutGapList);
+
+    /**
+     *  @brief Get a key identifying a given set of bad channels, used to decide whether the readout gaps must be rebuilt
+     *
+     *  @param badChannels the set of bad channels
+     */
+    static size_t GetBadChannelKey(const std::set<raw::ChannelID_t> &badChannels);
+
+    /**
+     *  @brief Get a key identifying the detector geometry (its name, gdml file and channel and tpc counts), used to validate cached readout gaps
+     */
+    static size_t GetGeometryKey();
+
+    /**
+     *  @brief Read a list of readout gaps from a cache file, if the file exists and was written for the specified geometry and bad channels
+     *
+     *  @param fileName the cache file name
+     *  @param geometryKey the key identifying the detector geometry
+     *  @param badChannelKey the key identifying the set of bad channels
+     *  @param readoutGapList the output list of readout gaps
+     *
+     *  @return whether the readout gaps were successfully read
+     */
+    static bool ReadReadoutGaps(const std::string &fileName, const size_t geometryKey, const size_t badChannelKey, LArReadoutGapList &readoutGapList);
+
+    /**
+     *  @brief Write a list of readout gaps to a cache file, logging a warning if the file can't be opened
+     *
+     *  @param fileName the cache file name
+     *  @param geometryKey the key identifying the detector geometry
+     *  @param badChannelKey the key identifying the set of bad channels
+     *  @param readoutGapList the list of readout gaps
+     */
+    static void WriteReadoutGaps(const std::string &fileName, const size_t geometryKey, const size_t badChannelKey, const LArReadoutGapList &readoutGapList);
+
+    /**
+     *  @brief  Get drift volume from a specified cryostat/tpc pair
+     *
+     *  @param  driftVolumeMap the output mapping between cryostat/tpc and drift volumes
+     *  @param  cstat the input cryostat unique ID
+     *  @param  tpc the input tpc unique ID
+     */
+    static const LArDriftVolume &GetDriftVolume(const LArDriftVolumeMap &driftVolumeMap, const unsigned int cstat, const unsigned int tpc);
+
     /**
      *  @brief  Get drift volume ID from a specified cryostat/tpc pair
      *
@@ -507,6 +947,277 @@ inline float LArDriftVolume::GetSigmaUVZ() const
     return m_sigmaUVZ;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline geo::View_t LArPlaneLookup::GetView() const
+{
+    return m_view;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline geo::View_t LArPlaneLookup::GetGlobalView() const
+{
+    return m_globalView;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int LArPlaneLookup::GetVolumeID() const
+{
+    return m_volumeID;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline float LArPlaneLookup::GetWirePitch() const
+{
+    return m_wirePitch;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double LArPlaneLookup::GetTickToXOffset() const
+{
+    return m_tickToXOffset;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double LArPlaneLookup::GetTickToXSlope() const
+{
+    return m_tickToXSlope;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int LArPlaneLookup::GetNWires() const
+{
+    return m_wireCenterY.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double LArPlaneLookup::ConvertTicksToX(const double ticks) const
+{
+    return (m_tickToXOffset + m_tickToXSlope * ticks);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double LArPlaneLookup::GetWireCenterY(const unsigned int wire) const
+{
+    if (wire >= m_wireCenterY.size())
+        throw cet::exception("LArPandora") << " LArPlaneLookup::GetWireCenterY --- wire " << wire << " is not in the lookup table ";
+
+    return m_wireCenterY[wire];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double LArPlaneLookup::GetWireCenterZ(const unsigned int wire) const
+{
+    if (wire >= m_wireCenterZ.size())
+        throw cet::exception("LArPandora") << " LArPlaneLookup::GetWireCenterZ --- wire " << wire << " is not in the lookup table ";
+
+    return m_wireCenterZ[wire];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArDetectorLookupTable::IsEmpty() const
+{
+    return m_planeList.empty();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const LArPlaneLookup &LArDetectorLookupTable::GetPlane(const unsigned int cstat, const unsigned int tpc, const unsigned int plane) const
+{
+    if ((cstat + 1 >= m_tpcOffsets.size()) || (m_tpcOffsets[cstat] + tpc >= m_tpcOffsets[cstat + 1]) || (plane >= m_maxPlanes))
+        throw cet::exception("LArPandora") << " LArDetectorLookupTable::GetPlane --- plane (" << cstat << ", " << tpc << ", " << plane << ") is not in the lookup table ";
+
+    return m_planeList[(m_tpcOffsets[cstat] + tpc) * m_maxPlanes + plane];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int LArTpcBox::GetCryostat() const
+{
+    return m_cryostat;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int LArTpcBox::GetTpc() const
+{
+    return m_tpc;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArTpcBox::IsNegativeDrift() const
+{
+    return m_isNegativeDrift;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double LArTpcBox::GetMin(const unsigned int axis) const
+{
+    return m_min[axis];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double LArTpcBox::GetMax(const unsigned int axis) const
+{
+    return m_max[axis];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArTpcBox::Contains(const double x, const double y, const double z) const
+{
+    return ((x >= m_min[0]) && (x <= m_max[0]) && (y >= m_min[1]) && (y <= m_max[1]) && (z >= m_min[2]) && (z <= m_max[2]));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArTpcGridIndex::IsEmpty() const
+{
+    return m_tpcBoxList.empty();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const LArTpcBox *LArTpcGridIndex::FindTpc(const double x, const double y, const double z) const
+{
+    if (m_tpcBoxList.empty())
+        return nullptr;
+
+    const double position[3] = {x, y, z};
+    unsigned int cell(0);
+
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        const double offset((position[axis] - m_origin[axis]) / m_cellSize[axis]);
+
+        // ATTN Also rejects nan coordinates
+        if (!(offset >= 0.) || !(offset <= static_cast<double>(m_nCells[axis])))
+            return nullptr;
+
+        const unsigned int index(std::min(static_cast<unsigned int>(offset), m_nCells[axis] - 1));
+        cell = cell * m_nCells[axis] + index;
+    }
+
+    for (unsigned int entry = m_cellOffsets[cell], entryEnd = m_cellOffsets[cell + 1]; entry < entryEnd; ++entry)
+    {
+        const LArTpcBox &tpcBox(m_tpcBoxList[m_cellEntries[entry]]);
+
+        if (tpcBox.Contains(x, y, z))
+            return &tpcBox;
+    }
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArReadoutGap::LArReadoutGap(const unsigned int cryostat, const unsigned int tpc, const unsigned int plane, const unsigned int firstWire,
+        const unsigned int lastWire) :
+    m_cryostat(cryostat), m_tpc(tpc), m_plane(plane), m_firstWire(firstWire), m_lastWire(lastWire)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int LArReadoutGap::GetCryostat() const
+{
+    return m_cryostat;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int LArReadoutGap::GetTpc() const
+{
+    return m_tpc;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int LArReadoutGap::GetPlane() const
+{
+    return m_plane;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int LArReadoutGap::GetFirstWire() const
+{
+    return m_firstWire;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int LArReadoutGap::GetLastWire() const
+{
+    return m_lastWire;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArReadoutGap::operator<(const LArReadoutGap &rhs) const
+{
+    if (m_cryostat != rhs.m_cryostat)
+        return (m_cryostat < rhs.m_cryostat);
+
+    if (m_tpc != rhs.m_tpc)
+        return (m_tpc < rhs.m_tpc);
+
+    if (m_plane != rhs.m_plane)
+        return (m_plane < rhs.m_plane);
+
+    if (m_firstWire != rhs.m_firstWire)
+        return (m_firstWire < rhs.m_firstWire);
+
+    return (m_lastWire < rhs.m_lastWire);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const LArDriftVolumeList &LArDetectorGeometry::GetDriftVolumeList() const
+{
+    return m_driftVolumeList;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const LArDriftVolumeMap &LArDetectorGeometry::GetDriftVolumeMap() const
+{
+    return m_driftVolumeMap;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const LArTpcGridIndex &LArDetectorGeometry::GetTpcGridIndex() const
+{
+    return m_tpcGridIndex;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const LArDetectorGapList &LArDetectorGeometry::GetDetectorGapList() const
+{
+    return m_detectorGapList;
+}
+
 } // namespace lar_pandora
 
 #endif // #ifndef LAR_PANDORA_GEOMETRY_H
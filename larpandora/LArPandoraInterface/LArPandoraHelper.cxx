@@ -40,9 +40,12 @@
 #include "Pandora/PandoraInternal.h"
 
 #include "larpandora/LArPandoraInterface/LArPandoraHelper.h"
+#include "larpandora/LArPandoraObjects/CompactSpacePoints.h"
 
+#include <algorithm>
 #include <limits>
 #include <iostream>
+#include <tuple>
 
 namespace lar_pandora
 {
@@ -223,6 +226,56 @@ void LArPandoraHelper::CollectPFParticles(const art::Event &evt, const std::stri
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+void LArPandoraHelper::CollectCompactSpacePoints(const art::Event &evt, const std::string &label, PFParticleVector &particleVector,
+    PFParticlesToRawSpacePoints &particlesToSpacePoints)
+{
+    art::Handle< std::vector<recob::PFParticle> > theParticles;
+    evt.getByLabel(label, theParticles);
+
+    if (!theParticles.isValid())
+    {
+        mf::LogDebug("LArPandora") << "  Failed to find particles... " << std::endl;
+        return;
+    }
+    else
+    {
+        mf::LogDebug("LArPandora") << "  Found: " << theParticles->size() << " PFParticles " << std::endl;
+    }
+
+    art::Handle< larpandoraobj::CompactSpacePoints > theCompactSpacePoints;
+    evt.getByLabel(label, theCompactSpacePoints);
+
+    if (!theCompactSpacePoints.isValid())
+    {
+        mf::LogDebug("LArPandora") << "  Failed to find compact space points... " << std::endl;
+        return;
+    }
+
+    if (theCompactSpacePoints->NParticles() != theParticles->size())
+        throw cet::exception("LArPandora") << " LArPandoraHelper::CollectCompactSpacePoints --- compact space points don't match the PFParticles ";
+
+    // The quantisation error is uniformly distributed over the resolution
+    const double variance(theCompactSpacePoints->Resolution() * theCompactSpacePoints->Resolution() / 12.);
+    const double err[6] = {variance, 0., variance, 0., 0., variance};
+
+    for (unsigned int i = 0; i < theParticles->size(); ++i)
+    {
+        const art::Ptr<recob::PFParticle> particle(theParticles, i);
+        particleVector.push_back(particle);
+
+        RawSpacePointVector &spacePoints(particlesToSpacePoints[particle]);
+        spacePoints.reserve(theCompactSpacePoints->ParticleEnd(i) - theCompactSpacePoints->ParticleBegin(i));
+
+        for (size_t j = theCompactSpacePoints->ParticleBegin(i); j < theCompactSpacePoints->ParticleEnd(i); ++j)
+        {
+            const double xyz[3] = {theCompactSpacePoints->X(j), theCompactSpacePoints->Y(j), theCompactSpacePoints->Z(j)};
+            spacePoints.emplace_back(xyz, err, 0., static_cast<int>(j));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 void LArPandoraHelper::CollectPFParticles(const art::Event &evt, const std::string &label, PFParticleVector &particleVector,
     PFParticlesToClusters &particlesToClusters)
 {
@@ -925,7 +978,15 @@ void LArPandoraHelper::CollectMCParticles(const art::Event &evt, const std::stri
 void LArPandoraHelper::BuildMCParticleHitMaps(const HitVector &hitVector, const SimChannelVector &simChannelVector,
     HitsToTrackIDEs &hitsToTrackIDEs)
 {
-    auto const* ts = lar::providerFrom<detinfo::DetectorClocksService>();
+    LArPandoraHelper::BuildMCParticleHitMaps(*lar::providerFrom<detinfo::DetectorClocksService>(), hitVector, simChannelVector, hitsToTrackIDEs);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraHelper::BuildMCParticleHitMaps(const detinfo::DetectorClocks &detectorClocks, const HitVector &hitVector,
+    const SimChannelVector &simChannelVector, HitsToTrackIDEs &hitsToTrackIDEs)
+{
+    const detinfo::DetectorClocks *const ts(&detectorClocks);
 
     SimChannelMap simChannelMap;
 
@@ -968,6 +1029,129 @@ void LArPandoraHelper::BuildMCParticleHitMaps(const HitVector &hitVector, const
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+void LArPandoraHelper::BuildMCParticleHitTable(const HitVector &hitVector, const SimChannelVector &simChannelVector,
+    HitTrackIDETable &hitTrackIDETable)
+{
+    LArPandoraHelper::BuildMCParticleHitTable(*lar::providerFrom<detinfo::DetectorClocksService>(), hitVector, simChannelVector, hitTrackIDETable);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraHelper::BuildMCParticleHitTable(const detinfo::DetectorClocks &detectorClocks, const HitVector &hitVector,
+    const SimChannelVector &simChannelVector, HitTrackIDETable &hitTrackIDETable)
+{
+    const detinfo::DetectorClocks *const ts(&detectorClocks);
+
+    if (hitVector.empty())
+        return;
+
+    const art::ProductID productID(hitVector.front().id());
+    size_t nKeys(0);
+
+    // Sort the hits by channel and then by start time
+    typedef std::tuple<raw::ChannelID_t, unsigned int, unsigned int, size_t> HitWindow;
+    std::vector<HitWindow> hitWindows;
+    hitWindows.reserve(hitVector.size());
+
+    for (size_t iHit = 0; iHit < hitVector.size(); ++iHit)
+    {
+        const art::Ptr<recob::Hit> &hit(hitVector.at(iHit));
+
+        if (hit.id() != productID)
+            throw cet::exception("LArPandora") << " LArPandoraHelper::BuildMCParticleHitTable --- input hits must come from a single data product ";
+
+        nKeys = std::max(nKeys, static_cast<size_t>(hit.key() + 1));
+
+        // ATTN: Need to convert TDCtick (integer) to TDC (unsigned integer) before passing to simChannel
+        const raw::TDCtick_t start_tick(ts->TPCTick2TDC(hit->PeakTimeMinusRMS()));
+        const raw::TDCtick_t end_tick(ts->TPCTick2TDC(hit->PeakTimePlusRMS()));
+        const unsigned int start_tdc((start_tick < 0) ? 0 : start_tick);
+        const unsigned int end_tdc(end_tick);
+
+        if (start_tdc > end_tdc)
+            continue; // Hit undershoots the readout window [continue]
+
+        hitWindows.emplace_back(hit->Channel(), start_tdc, end_tdc, iHit);
+    }
+
+    std::sort(hitWindows.begin(), hitWindows.end());
+    hitTrackIDETable.Reset(productID, nKeys);
+
+    SimChannelMap simChannelMap;
+
+    for (const art::Ptr<sim::SimChannel> &simChannel : simChannelVector)
+        simChannelMap.insert(SimChannelMap::value_type(simChannel->Channel(), simChannel));
+
+    std::map<int, std::pair<float, float> > trackIDToDeposits;
+    TrackIDEVector trackCollection;
+
+    for (std::vector<HitWindow>::const_iterator hIter = hitWindows.begin(), hIterEnd = hitWindows.end(); hIter != hIterEnd; )
+    {
+        const raw::ChannelID_t channel(std::get<0>(*hIter));
+        std::vector<HitWindow>::const_iterator hIterChannelEnd(hIter);
+
+        while ((hIterEnd != hIterChannelEnd) && (std::get<0>(*hIterChannelEnd) == channel))
+            ++hIterChannelEnd;
+
+        SimChannelMap::const_iterator sIter = simChannelMap.find(channel);
+
+        if (simChannelMap.end() == sIter)
+        {
+            hIter = hIterChannelEnd;
+            continue; // Hits have no truth information [continue]
+        }
+
+        // As the hit start times increase, the first relevant deposit can only move forward
+        const auto &tdcIDEs(sIter->second->TDCIDEMap());
+        auto tdcStart(tdcIDEs.begin());
+
+        for (; hIter != hIterChannelEnd; ++hIter)
+        {
+            const unsigned int start_tdc(std::get<1>(*hIter)), end_tdc(std::get<2>(*hIter));
+
+            while ((tdcIDEs.end() != tdcStart) && (tdcStart->first < start_tdc))
+                ++tdcStart;
+
+            // Replicate sim::SimChannel::TrackIDEs, accumulating energy and electrons for each track id in this window
+            trackIDToDeposits.clear();
+            float totalE(0.f);
+
+            for (auto tdcIter = tdcStart; (tdcIDEs.end() != tdcIter) && (tdcIter->first <= end_tdc); ++tdcIter)
+            {
+                for (const sim::IDE &ide : tdcIter->second)
+                {
+                    std::pair<float, float> &deposits(trackIDToDeposits[ide.trackID]);
+                    deposits.first += ide.energy;
+                    deposits.second += ide.numElectrons;
+                    totalE += ide.energy;
+                }
+            }
+
+            if (trackIDToDeposits.empty())
+                continue; // Hit has no truth information [continue]
+
+            if (totalE < 1.e-5f)
+                totalE = 1.f;
+
+            trackCollection.clear();
+
+            for (const auto &mapEntry : trackIDToDeposits)
+            {
+                sim::TrackIDE trackIDE;
+                trackIDE.trackID = mapEntry.first;
+                trackIDE.energyFrac = mapEntry.second.first / totalE;
+                trackIDE.energy = mapEntry.second.first;
+                trackIDE.numElectrons = mapEntry.second.second;
+                trackCollection.push_back(trackIDE);
+            }
+
+            hitTrackIDETable.AddTrackIDEs(hitVector.at(std::get<3>(*hIter)), trackCollection.begin(), trackCollection.end());
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 void LArPandoraHelper::BuildMCParticleHitMaps(const HitsToTrackIDEs &hitsToTrackIDEs, const MCTruthToMCParticles &truthToParticles,
     MCParticlesToHits &particlesToHits, HitsToMCParticles &hitsToParticles, const DaughterMode daughterMode)
 {
@@ -1481,4 +1665,48 @@ LArPandoraHelper::TriggerInformation::TriggerInformation() :
 {
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+HitTrackIDETable::HitTrackIDETable()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void HitTrackIDETable::Reset(const art::ProductID &productID, const size_t nKeys)
+{
+    m_productID = productID;
+    m_keyToEntries.assign(nKeys, EntryRange(0, 0));
+    m_entries.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void HitTrackIDETable::AddTrackIDEs(const art::Ptr<recob::Hit> &hit, const TrackIDEVector::const_iterator &begin, const TrackIDEVector::const_iterator &end)
+{
+    if ((hit.id() != m_productID) || (hit.key() >= m_keyToEntries.size()))
+        throw cet::exception("LArPandora") << " HitTrackIDETable::AddTrackIDEs --- hit is not described by this table ";
+
+    EntryRange &entryRange(m_keyToEntries[hit.key()]);
+
+    if (entryRange.second > entryRange.first)
+        throw cet::exception("LArPandora") << " HitTrackIDETable::AddTrackIDEs --- hit has already been added to this table ";
+
+    entryRange.first = m_entries.size();
+    m_entries.insert(m_entries.end(), begin, end);
+    entryRange.second = m_entries.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+HitTrackIDETable::TrackIDERange HitTrackIDETable::GetTrackIDEs(const art::Ptr<recob::Hit> &hit) const
+{
+    if ((hit.id() != m_productID) || (hit.key() >= m_keyToEntries.size()))
+        return TrackIDERange(m_entries.end(), m_entries.end());
+
+    const EntryRange &entryRange(m_keyToEntries[hit.key()]);
+    return TrackIDERange(m_entries.begin() + entryRange.first, m_entries.begin() + entryRange.second);
+}
+
 } // namespace lar_pandora
@@ -16,6 +16,7 @@
 #include <vector>
 
 namespace anab {class CosmicTag; class T0;}
+namespace detinfo {class DetectorClocks;}
 namespace pandora {class ParticleFlowObject; class Vertex; typedef std::vector<int> IntVector;}
 namespace recob {class Cluster; class Hit; class PFParticle; class Seed; class Shower; class Slice; class SpacePoint; class Track; class Vertex; class Wire;}
 namespace larpandoraobj {class PFParticleMetadata;}
@@ -41,6 +42,7 @@ typedef std::vector< art::Ptr<recob::PFParticle> >  PFParticleVector;
 typedef std::vector< art::Ptr<simb::MCTruth> >      MCTruthVector;
 typedef std::vector< art::Ptr<simb::MCParticle> >   MCParticleVector;
 typedef std::vector< simb::MCParticle>              RawMCParticleVector;
+typedef std::vector< recob::SpacePoint >            RawSpacePointVector;
 typedef std::vector< art::Ptr<sim::SimChannel> >    SimChannelVector;
 typedef std::vector< sim::TrackIDE >                TrackIDEVector;
 typedef std::vector< art::Ptr<anab::CosmicTag> >    CosmicTagVector;
@@ -75,6 +77,7 @@ typedef std::map< art::Ptr<recob::Hit>,        art::Ptr<simb::MCTruth> >      Hi
 typedef std::map< art::Ptr<recob::Hit>,        TrackIDEVector >               HitsToTrackIDEs;
 typedef std::map< art::Ptr<recob::Track>,      CosmicTagVector >              TracksToCosmicTags;
 typedef std::map< art::Ptr<recob::PFParticle>, T0Vector >                     PFParticlesToT0s;
+typedef std::map< art::Ptr<recob::PFParticle>, RawSpacePointVector >          PFParticlesToRawSpacePoints;
 
 typedef std::map< int, art::Ptr<recob::PFParticle> >  PFParticleMap;
 typedef std::map< int, art::Ptr<recob::Cluster> >     ClusterMap;
@@ -87,6 +90,51 @@ typedef std::map< const pandora::ParticleFlowObject*, size_t> ThreeDParticleMap;
 typedef std::map< const pandora::Vertex*, unsigned int> ThreeDVertexMap;
 typedef std::map< int, HitVector > HitArray;
 
+/**
+ *  @brief  HitTrackIDETable class, a flat table of the true energy deposits for each hit, indexed by hit key
+ */
+class HitTrackIDETable
+{
+public:
+    typedef std::pair<TrackIDEVector::const_iterator, TrackIDEVector::const_iterator> TrackIDERange;
+
+    /**
+     *  @brief  Default constructor
+     */
+    HitTrackIDETable();
+
+    /**
+     *  @brief  Reset the table, for hits from a single data product
+     *
+     *  @param  productID the id of the hit data product
+     *  @param  nKeys the number of hit keys to reserve
+     */
+    void Reset(const art::ProductID &productID, const size_t nKeys);
+
+    /**
+     *  @brief  Add the true energy deposits for a hit, which must not already have been added
+     *
+     *  @param  hit the hit
+     *  @param  begin the first energy deposit to add
+     *  @param  end the end of the energy deposits to add
+     */
+    void AddTrackIDEs(const art::Ptr<recob::Hit> &hit, const TrackIDEVector::const_iterator &begin, const TrackIDEVector::const_iterator &end);
+
+    /**
+     *  @brief  Get the true energy deposits for a hit (an empty range if there are none)
+     *
+     *  @param  hit the hit
+     */
+    TrackIDERange GetTrackIDEs(const art::Ptr<recob::Hit> &hit) const;
+
+private:
+    typedef std::pair<size_t, size_t> EntryRange;
+
+    art::ProductID              m_productID;    ///< The id of the hit data product
+    std::vector<EntryRange>     m_keyToEntries; ///< The [begin, end) indices into m_entries for each hit key
+    TrackIDEVector              m_entries;      ///< The true energy deposits, stored contiguously for each hit
+};
+
 /**
  *  @brief  LArPandoraHelper class
  */
@@ -196,6 +244,19 @@ public:
     static void CollectPFParticles(const art::Event &evt, const std::string &label, PFParticleVector &particleVector,
         PFParticlesToSpacePoints &particlesToSpacePoints);
 
+    /**
+     *  @brief Collect the reconstructed PFParticles and their compact 3D hit positions from the ART event record, decoding the
+     *         positions into SpacePoint objects. The SpacePoint errors reflect the quantisation, the chi2 is zero and the ids are
+     *         the indices of the points in the compact product
+     *
+     *  @param evt the ART event record
+     *  @param label the label for the PFParticle list and the compact 3D hit positions in the event
+     *  @param particleVector the output vector of PFParticle objects
+     *  @param particlesToSpacePoints the output map from PFParticle to decoded SpacePoint objects
+     */
+    static void CollectCompactSpacePoints(const art::Event &evt, const std::string &label, PFParticleVector &particleVector,
+        PFParticlesToRawSpacePoints &particlesToSpacePoints);
+
     /**
      *  @brief Collect the reconstructed PFParticles and associated Clusters from the ART event record
      *
@@ -430,6 +491,40 @@ public:
      */
     static void BuildMCParticleHitMaps(const HitVector &hitVector, const SimChannelVector &simChannelVector, HitsToTrackIDEs &hitsToTrackIDEs);
 
+    /**
+     *  @brief Collect the links from reconstructed hits to their true energy deposits, using a given detector clocks provider. No services
+     *         are accessed, so this may be called away from the module thread
+     *
+     *  @param detectorClocks the detector clocks provider
+     *  @param hitVector the input vector of reconstructed hits
+     *  @param simChannelVector the input vector of SimChannels
+     *  @param hitsToTrackIDEs the out map from hits to true energy deposits
+     */
+    static void BuildMCParticleHitMaps(const detinfo::DetectorClocks &detectorClocks, const HitVector &hitVector, const SimChannelVector &simChannelVector,
+        HitsToTrackIDEs &hitsToTrackIDEs);
+
+    /**
+     *  @brief Collect the links from reconstructed hits to their true energy deposits, sorting hits by channel and start time
+     *         so that the time-ordered deposits of each SimChannel are walked only once
+     *
+     *  @param hitVector the input vector of reconstructed hits, which must all come from a single data product
+     *  @param simChannelVector the input vector of SimChannels
+     *  @param hitTrackIDETable the output table of true energy deposits for each hit
+     */
+    static void BuildMCParticleHitTable(const HitVector &hitVector, const SimChannelVector &simChannelVector, HitTrackIDETable &hitTrackIDETable);
+
+    /**
+     *  @brief Collect the links from reconstructed hits to their true energy deposits, as above, using a given detector clocks provider.
+     *         No services are accessed, so this may be called away from the module thread
+     *
+     *  @param detectorClocks the detector clocks provider
+     *  @param hitVector the input vector of reconstructed hits, which must all come from a single data product
+     *  @param simChannelVector the input vector of SimChannels
+     *  @param hitTrackIDETable the output table of true energy deposits for each hit
+     */
+    static void BuildMCParticleHitTable(const detinfo::DetectorClocks &detectorClocks, const HitVector &hitVector,
+        const SimChannelVector &simChannelVector, HitTrackIDETable &hitTrackIDETable);
+
     /**
      *  @brief Build mapping between Hits and MCParticles, starting from Hit/TrackIDE/MCParticle information
      *
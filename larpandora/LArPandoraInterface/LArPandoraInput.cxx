@@ -12,9 +12,6 @@
 
 #include "lardataobj/RecoBase/Hit.h"
 
-#include "larevt/CalibrationDBI/Interface/ChannelStatusService.h"
-#include "larevt/CalibrationDBI/Interface/ChannelStatusProvider.h"
-
 #include "nusimdata/SimulationBase/MCTruth.h"
 
 #include "larsim/MCCheater/ParticleInventoryService.h"
@@ -32,117 +29,89 @@
 
 #include "larpandora/LArPandoraInterface/ILArPandora.h"
 #include "larpandora/LArPandoraInterface/LArPandoraInput.h"
+#include "larpandora/LArPandoraInterface/LArPandoraPooledObjects.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <limits>
 
 namespace lar_pandora
 {
 
-void LArPandoraInput::CreatePandoraHits2D(const Settings &settings, const LArDriftVolumeMap &driftVolumeMap, const HitVector &hitVector, IdToHitMap &idToHitMap)
+void LArPandoraInput::CreatePandoraHits2D(const Settings &settings, const LArDetectorLookupTable &lookupTable, const HitVector &hitVector, IdToHitMap &idToHitMap)
 {
     mf::LogDebug("LArPandora") << " *** LArPandoraInput::CreatePandoraHits2D(...) *** " << std::endl;
 
     if (!settings.m_pPrimaryPandora)
         throw cet::exception("LArPandora") << "CreatePandoraHits2D - primary Pandora instance does not exist ";
 
-    const pandora::Pandora *pPandora(settings.m_pPrimaryPandora);
+    // Gather the ART hits into flat buffers, then convert them in a single pass
+    HitConversionConstants constants;
+    LArPandoraInput::LoadHitConversionConstants(settings, constants);
 
-    art::ServiceHandle<geo::Geometry> theGeometry;
-    auto const* theDetector = lar::providerFrom<detinfo::DetectorPropertiesService>();
+    HitBatch hitBatch;
+    LArPandoraInput::FillHitBatch(lookupTable, hitVector, hitBatch);
+    LArPandoraInput::ConvertHitBatch(settings, constants, hitBatch);
 
-    // Loop over ART hits
-    int hitCounter(0);
+    HitFilterCounters hitFilterCounters;
+    LArPandoraInput::FilterHitBatch(HitFilter(), hitBatch, hitFilterCounters);
 
-    lar_content::LArCaloHitFactory caloHitFactory;
+    LArPandoraInput::CreatePandoraHits2D(settings, hitBatch, idToHitMap);
+}
 
-    for (HitVector::const_iterator iter = hitVector.begin(), iterEnd = hitVector.end(); iter != iterEnd; ++iter)
-    {
-        const art::Ptr<recob::Hit> hit = *iter;
-        const geo::WireID hit_WireID(hit->WireID());
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInput::CreatePandoraHits2D(const Settings &settings, const HitBatch &hitBatch, IdToHitMap &idToHitMap)
+{
+    if (!settings.m_pPrimaryPandora)
+        throw cet::exception("LArPandora") << "CreatePandoraHits2D - primary Pandora instance does not exist ";
 
-        // Get basic hit properties (view, time, charge)
-        const geo::View_t hit_View(hit->View());
-        const double hit_Charge(hit->Integral());
-        const double hit_Time(hit->PeakTime());
-        const double hit_TimeStart(hit->PeakTimeMinusRMS());
-        const double hit_TimeEnd(hit->PeakTimePlusRMS());
+    const pandora::Pandora *pPandora(settings.m_pPrimaryPandora);
 
-        // Get hit X coordinate and, if using a single global drift volume, remove any out-of-time hits here
-        const double xpos_cm(theDetector->ConvertTicksToX(hit_Time, hit_WireID.Plane, hit_WireID.TPC, hit_WireID.Cryostat));
-        const double dxpos_cm(std::fabs(theDetector->ConvertTicksToX(hit_TimeEnd, hit_WireID.Plane, hit_WireID.TPC, hit_WireID.Cryostat) -
-            theDetector->ConvertTicksToX(hit_TimeStart, hit_WireID.Plane, hit_WireID.TPC, hit_WireID.Cryostat)));
+    // Loop over converted hits
+    int hitCounter(0);
+    idToHitMap.reserve(hitBatch.Size());
 
-        // Get hit Y and Z coordinates, based on central position of wire
-        double xyz[3];
-        theGeometry->Cryostat(hit_WireID.Cryostat).TPC(hit_WireID.TPC).Plane(hit_WireID.Plane).Wire(hit_WireID.Wire).GetCenter(xyz);
-        const double y0_cm(xyz[1]);
-        const double z0_cm(xyz[2]);
+    lar_content::LArCaloHitFactory standardCaloHitFactory;
+    LArPooledCaloHitFactory pooledCaloHitFactory;
+    const lar_content::LArCaloHitFactory &caloHitFactory(settings.m_usePooledInputObjects ? pooledCaloHitFactory : standardCaloHitFactory);
 
-        // Get other hit properties here
-        const double wire_pitch_cm(theGeometry->WirePitch(hit_View)); // cm
-        const double mips(LArPandoraInput::GetMips(settings, hit_Charge, hit_View));
+    for (size_t iHit = 0, nHits = hitBatch.Size(); iHit < nHits; ++iHit)
+    {
+        const double mips(hitBatch.m_mips[iHit]);
 
         // Create Pandora CaloHit
         lar_content::LArCaloHitParameters caloHitParameters;
 
-        try
-        {
-            caloHitParameters.m_expectedDirection = pandora::CartesianVector(0., 0., 1.);
-            caloHitParameters.m_cellNormalVector = pandora::CartesianVector(0., 0., 1.);
-            caloHitParameters.m_cellSize0 = settings.m_dx_cm;
-            caloHitParameters.m_cellSize1 = (settings.m_useHitWidths ? dxpos_cm : settings.m_dx_cm);
-            caloHitParameters.m_cellThickness = wire_pitch_cm;
-            caloHitParameters.m_cellGeometry = pandora::RECTANGULAR;
-            caloHitParameters.m_time = 0.;
-            caloHitParameters.m_nCellRadiationLengths = settings.m_dx_cm / settings.m_rad_cm;
-            caloHitParameters.m_nCellInteractionLengths = settings.m_dx_cm / settings.m_int_cm;
-            caloHitParameters.m_isDigital = false;
-            caloHitParameters.m_hitRegion = pandora::SINGLE_REGION;
-            caloHitParameters.m_layer = 0;
-            caloHitParameters.m_isInOuterSamplingLayer = false;
-            caloHitParameters.m_inputEnergy = hit_Charge;
-            caloHitParameters.m_mipEquivalentEnergy = mips;
-            caloHitParameters.m_electromagneticEnergy = mips * settings.m_mips_to_gev;
-            caloHitParameters.m_hadronicEnergy = mips * settings.m_mips_to_gev;
-            caloHitParameters.m_pParentAddress = (void*)((intptr_t)(++hitCounter));
-            caloHitParameters.m_larTPCVolumeId = LArPandoraGeometry::GetVolumeID(driftVolumeMap, hit_WireID.Cryostat, hit_WireID.TPC);
-
-            const geo::View_t pandora_View(LArPandoraGeometry::GetGlobalView(hit_WireID.Cryostat, hit_WireID.TPC, hit_View));
-
-            if (pandora_View == geo::kW)
-            {
-                caloHitParameters.m_hitType = pandora::TPC_VIEW_W;
-                const double wpos_cm(pPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoW(y0_cm, z0_cm));
-                caloHitParameters.m_positionVector = pandora::CartesianVector(xpos_cm, 0., wpos_cm);
-            }
-            else if(pandora_View == geo::kU)
-            {
-                caloHitParameters.m_hitType = pandora::TPC_VIEW_U;
-                const double upos_cm(pPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoU(y0_cm, z0_cm));
-                caloHitParameters.m_positionVector = pandora::CartesianVector(xpos_cm, 0., upos_cm);
-            }
-            else if(pandora_View == geo::kV)
-            {
-                caloHitParameters.m_hitType = pandora::TPC_VIEW_V;
-                const double vpos_cm(pPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoV(y0_cm, z0_cm));
-                caloHitParameters.m_positionVector = pandora::CartesianVector(xpos_cm, 0., vpos_cm);
-            }
-            else
-            {
-                throw cet::exception("LArPandora") << "CreatePandoraHits2D - this wire view not recognised (View=" << hit_View << ") ";
-            }
-        }
-        catch (const pandora::StatusCodeException &)
-        {
-            mf::LogWarning("LArPandora") << "CreatePandoraHits2D - invalid calo hit parameter provided, all assigned values must be finite, calo hit omitted " << std::endl;
-            continue;
-        }
+        // ATTN All parameters are finite, having been validated by FilterHitBatch
+        caloHitParameters.m_positionVector = pandora::CartesianVector(hitBatch.m_x[iHit], 0., hitBatch.m_projection[iHit]);
+        caloHitParameters.m_expectedDirection = pandora::CartesianVector(0., 0., 1.);
+        caloHitParameters.m_cellNormalVector = pandora::CartesianVector(0., 0., 1.);
+        caloHitParameters.m_cellSize0 = settings.m_dx_cm;
+        caloHitParameters.m_cellSize1 = (settings.m_useHitWidths ? hitBatch.m_dx[iHit] : settings.m_dx_cm);
+        caloHitParameters.m_cellThickness = hitBatch.m_wirePitch[iHit];
+        caloHitParameters.m_cellGeometry = pandora::RECTANGULAR;
+        caloHitParameters.m_time = 0.;
+        caloHitParameters.m_nCellRadiationLengths = settings.m_dx_cm / settings.m_rad_cm;
+        caloHitParameters.m_nCellInteractionLengths = settings.m_dx_cm / settings.m_int_cm;
+        caloHitParameters.m_isDigital = false;
+        caloHitParameters.m_hitRegion = pandora::SINGLE_REGION;
+        caloHitParameters.m_layer = 0;
+        caloHitParameters.m_isInOuterSamplingLayer = false;
+        caloHitParameters.m_inputEnergy = hitBatch.m_integral[iHit];
+        caloHitParameters.m_mipEquivalentEnergy = mips;
+        caloHitParameters.m_electromagneticEnergy = mips * settings.m_mips_to_gev;
+        caloHitParameters.m_hadronicEnergy = mips * settings.m_mips_to_gev;
+        caloHitParameters.m_pParentAddress = (void*)((intptr_t)(++hitCounter));
+        caloHitParameters.m_larTPCVolumeId = hitBatch.m_volumeID[iHit];
+        caloHitParameters.m_hitType = hitBatch.m_hitType[iHit];
 
         // Store the hit address
         if (hitCounter >= settings.m_uidOffset)
             throw cet::exception("LArPandora") << "CreatePandoraHits2D - detected an excessive number of hits (" << hitCounter << ") ";
 
-        idToHitMap[hitCounter] = hit;
+        idToHitMap[hitCounter] = hitBatch.m_hits[iHit];
 
         // Create the Pandora hit
         try
@@ -159,6 +128,287 @@ void LArPandoraInput::CreatePandoraHits2D(const Settings &settings, const LArDri
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+void LArPandoraInput::LoadHitConversionConstants(const Settings &settings, HitConversionConstants &constants)
+{
+    if (!settings.m_pPrimaryPandora)
+        throw cet::exception("LArPandora") << "LoadHitConversionConstants - primary Pandora instance does not exist ";
+
+    const pandora::LArTransformationPlugin *const pTransform(settings.m_pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin());
+
+    // The (y, z) to (u, v, w) transformations are linear, so are fully described by their values at three points
+    for (const geo::View_t view : {geo::kU, geo::kV, geo::kW})
+    {
+        const unsigned int index(LArPandoraInput::GetViewIndex(view));
+        const double origin(LArPandoraInput::ProjectYZ(pTransform, view, 0., 0.));
+        const double yCoefficient(LArPandoraInput::ProjectYZ(pTransform, view, 1., 0.) - origin);
+        const double zCoefficient(LArPandoraInput::ProjectYZ(pTransform, view, 0., 1.) - origin);
+
+        // Check linearity at a well-separated test point, as the batched projection relies upon it
+        const double yTest(1000.), zTest(1000.);
+        const double expected(origin + yCoefficient * yTest + zCoefficient * zTest);
+
+        if (std::fabs(LArPandoraInput::ProjectYZ(pTransform, view, yTest, zTest) - expected) > 1.e-3 * (1. + std::fabs(expected)))
+            throw cet::exception("LArPandora") << "LoadHitConversionConstants - transformation plugin is not linear in (y, z), view " << view;
+
+        constants.m_projectionOrigin[index] = origin;
+        constants.m_projectionY[index] = yCoefficient;
+        constants.m_projectionZ[index] = zCoefficient;
+    }
+
+    auto const* theDetector = lar::providerFrom<detinfo::DetectorPropertiesService>();
+    constants.m_electronsToADC = theDetector->ElectronsToADC();
+    constants.m_adcToElectrons = 1. / (constants.m_electronsToADC * settings.m_recombination_factor);
+    constants.m_electronsToMips = 1000. / (util::kGeVToElectrons * settings.m_dEdX_mip);
+
+    // Tabulate the Birks correction, stopping before the first node at which the exact calculation saturates or becomes unphysical
+    constants.m_birksTable.clear();
+    constants.m_birksTableMaxDQdX = 0.;
+    constants.m_birksTableInverseStep = 0.;
+    constants.m_birksTableMaxPosition = 0.;
+
+    if (!settings.m_useBirksCorrection || (settings.m_birksTableNodes < 2) || !(settings.m_birksTableMaxDQdX > 0.))
+        return;
+
+    const double step(settings.m_birksTableMaxDQdX / static_cast<double>(settings.m_birksTableNodes - 1));
+    constants.m_birksTable.reserve(settings.m_birksTableNodes + 1);
+
+    for (unsigned int iNode = 0; iNode < settings.m_birksTableNodes; ++iNode)
+    {
+        const double mips(theDetector->BirksCorrection(step * static_cast<double>(iNode)) / settings.m_dEdX_mip);
+
+        if (!std::isfinite(mips) || (mips < 0.) || (mips > settings.m_mips_max))
+            break;
+
+        constants.m_birksTable.push_back(mips);
+    }
+
+    if (constants.m_birksTable.size() < 2)
+    {
+        constants.m_birksTable.clear();
+        return;
+    }
+
+    // ATTN The padding node allows interpolation from the last node without a bounds check
+    constants.m_birksTableMaxPosition = static_cast<double>(constants.m_birksTable.size() - 1);
+    constants.m_birksTableMaxDQdX = step * constants.m_birksTableMaxPosition;
+    constants.m_birksTableInverseStep = 1. / step;
+    constants.m_birksTable.push_back(constants.m_birksTable.back());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+double LArPandoraInput::GetBirksTableMaxDeviation(const Settings &settings, const HitConversionConstants &constants)
+{
+    if (constants.m_birksTable.empty())
+        return 0.;
+
+    auto const* theDetector = lar::providerFrom<detinfo::DetectorPropertiesService>();
+    const double step(1. / constants.m_birksTableInverseStep);
+    double maxDeviation(0.);
+
+    for (size_t iNode = 0, nIntervals = constants.m_birksTable.size() - 2; iNode < nIntervals; ++iNode)
+    {
+        const double dQdX(step * (static_cast<double>(iNode) + 0.5));
+        const double exactMips(theDetector->BirksCorrection(dQdX) / settings.m_dEdX_mip);
+        maxDeviation = std::max(maxDeviation, std::fabs(constants.GetTabulatedMips(dQdX) - exactMips));
+    }
+
+    return maxDeviation;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInput::FillHitBatch(const LArDetectorLookupTable &lookupTable, const HitVector &hitVector, HitBatch &hitBatch)
+{
+    if (lookupTable.IsEmpty())
+        throw cet::exception("LArPandora") << "FillHitBatch - detector lookup table has not been loaded ";
+
+    hitBatch.Clear();
+    hitBatch.Reserve(hitVector.size());
+
+    for (const art::Ptr<recob::Hit> &hit : hitVector)
+    {
+        const geo::WireID hit_WireID(hit->WireID());
+
+        // Get the precomputed readout properties of this plane
+        const LArPlaneLookup &plane(lookupTable.GetPlane(hit_WireID.Cryostat, hit_WireID.TPC, hit_WireID.Plane));
+        const geo::View_t pandora_View(plane.GetGlobalView());
+
+        if ((pandora_View != geo::kU) && (pandora_View != geo::kV) && (pandora_View != geo::kW))
+            throw cet::exception("LArPandora") << "FillHitBatch - this wire view not recognised (View=" << hit->View() << ") ";
+
+        hitBatch.m_hits.push_back(hit);
+        hitBatch.m_hitType.push_back((pandora_View == geo::kU) ? pandora::TPC_VIEW_U : (pandora_View == geo::kV) ? pandora::TPC_VIEW_V : pandora::TPC_VIEW_W);
+        hitBatch.m_viewIndex.push_back(LArPandoraInput::GetViewIndex(pandora_View));
+        hitBatch.m_volumeID.push_back(plane.GetVolumeID());
+        hitBatch.m_peakTime.push_back(hit->PeakTime());
+        hitBatch.m_timeStart.push_back(hit->PeakTimeMinusRMS());
+        hitBatch.m_timeEnd.push_back(hit->PeakTimePlusRMS());
+        hitBatch.m_integral.push_back(hit->Integral());
+        hitBatch.m_tickToXOffset.push_back(plane.GetTickToXOffset());
+        hitBatch.m_tickToXSlope.push_back(plane.GetTickToXSlope());
+        hitBatch.m_wireY.push_back(plane.GetWireCenterY(hit_WireID.Wire));
+        hitBatch.m_wireZ.push_back(plane.GetWireCenterZ(hit_WireID.Wire));
+        hitBatch.m_wirePitch.push_back(plane.GetWirePitch());
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInput::ConvertHitBatch(const Settings &settings, const HitConversionConstants &constants, HitBatch &hitBatch)
+{
+    const size_t nHits(hitBatch.Size());
+
+    hitBatch.m_x.resize(nHits);
+    hitBatch.m_dx.resize(nHits);
+    hitBatch.m_projection.resize(nHits);
+    hitBatch.m_mips.resize(nHits);
+
+    // ATTN The loops below are kept free of branches and function calls, so that the compiler is able to vectorise them
+    const double *const pPeakTime(hitBatch.m_peakTime.data());
+    const double *const pTimeStart(hitBatch.m_timeStart.data());
+    const double *const pTimeEnd(hitBatch.m_timeEnd.data());
+    const double *const pOffset(hitBatch.m_tickToXOffset.data());
+    const double *const pSlope(hitBatch.m_tickToXSlope.data());
+    const double *const pWireY(hitBatch.m_wireY.data());
+    const double *const pWireZ(hitBatch.m_wireZ.data());
+    const double *const pWirePitch(hitBatch.m_wirePitch.data());
+    const double *const pIntegral(hitBatch.m_integral.data());
+    const unsigned char *const pViewIndex(hitBatch.m_viewIndex.data());
+
+    double *const pX(hitBatch.m_x.data());
+    double *const pDx(hitBatch.m_dx.data());
+    double *const pProjection(hitBatch.m_projection.data());
+    double *const pMips(hitBatch.m_mips.data());
+
+    // Drift coordinate and hit width
+    for (size_t iHit = 0; iHit < nHits; ++iHit)
+    {
+        pX[iHit] = pOffset[iHit] + pSlope[iHit] * pPeakTime[iHit];
+        pDx[iHit] = std::fabs(pSlope[iHit] * (pTimeEnd[iHit] - pTimeStart[iHit]));
+    }
+
+    // Wire coordinate, projected into the pandora u, v or w view
+    for (size_t iHit = 0; iHit < nHits; ++iHit)
+    {
+        const unsigned char index(pViewIndex[iHit]);
+        pProjection[iHit] = constants.m_projectionOrigin[index] + constants.m_projectionY[index] * pWireY[iHit] +
+            constants.m_projectionZ[index] * pWireZ[iHit];
+    }
+
+    // Convert charge in ADCs to approximate MIPs; dQdX in e/cm is stored temporarily in the mips buffer
+    const double adcToElectrons(constants.m_adcToElectrons);
+
+    for (size_t iHit = 0; iHit < nHits; ++iHit)
+        pMips[iHit] = pIntegral[iHit] / pWirePitch[iHit] * adcToElectrons;
+
+    if (settings.m_useBirksCorrection && !constants.m_birksTable.empty())
+    {
+        const std::vector<double> dQdX(pMips, pMips + nHits);
+
+        for (size_t iHit = 0; iHit < nHits; ++iHit)
+            pMips[iHit] = constants.GetTabulatedMips(dQdX[iHit]);
+
+        // Use the exact calculation for any hits outside the tabulated range
+        auto const* theDetector = lar::providerFrom<detinfo::DetectorPropertiesService>();
+        const double maxDQdX(constants.m_birksTableMaxDQdX);
+
+        for (size_t iHit = 0; iHit < nHits; ++iHit)
+        {
+            if ((dQdX[iHit] < 0.) || (dQdX[iHit] > maxDQdX))
+                pMips[iHit] = theDetector->BirksCorrection(dQdX[iHit]) / settings.m_dEdX_mip;
+        }
+    }
+    else if (settings.m_useBirksCorrection)
+    {
+        auto const* theDetector = lar::providerFrom<detinfo::DetectorPropertiesService>();
+
+        for (size_t iHit = 0; iHit < nHits; ++iHit)
+            pMips[iHit] = theDetector->BirksCorrection(pMips[iHit]) / settings.m_dEdX_mip;
+    }
+    else
+    {
+        const double electronsToMips(constants.m_electronsToMips);
+
+        for (size_t iHit = 0; iHit < nHits; ++iHit)
+            pMips[iHit] *= electronsToMips;
+    }
+
+    const double mipsIfNegative(settings.m_mips_if_negative), mipsMax(settings.m_mips_max);
+
+    for (size_t iHit = 0; iHit < nHits; ++iHit)
+    {
+        const double mips(pMips[iHit] < 0. ? mipsIfNegative : pMips[iHit]);
+        pMips[iHit] = (mips > mipsMax ? mipsMax : mips);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInput::FilterHitBatch(const HitFilter &hitFilter, HitBatch &hitBatch, HitFilterCounters &hitFilterCounters)
+{
+    const size_t nHits(hitBatch.Size());
+
+    if (hitBatch.m_x.size() != nHits)
+        throw cet::exception("LArPandora") << "FilterHitBatch - hit batch has not been converted ";
+
+    std::vector<bool> isAccepted(nHits, false);
+    hitFilterCounters.m_nInput += nHits;
+
+    for (size_t iHit = 0; iHit < nHits; ++iHit)
+    {
+        // ATTN Pandora will not accept non-finite calo hit parameters
+        if (!std::isfinite(hitBatch.m_x[iHit]) || !std::isfinite(hitBatch.m_dx[iHit]) || !std::isfinite(hitBatch.m_projection[iHit]) ||
+            !std::isfinite(hitBatch.m_mips[iHit]) || !std::isfinite(hitBatch.m_integral[iHit]) || !std::isfinite(hitBatch.m_wirePitch[iHit]))
+        {
+            ++hitFilterCounters.m_nNonFinite;
+            continue;
+        }
+
+        if (hitBatch.m_integral[iHit] < hitFilter.m_minIntegral)
+        {
+            ++hitFilterCounters.m_nBelowMinIntegral;
+            continue;
+        }
+
+        if ((hitBatch.m_peakTime[iHit] < hitFilter.m_minPeakTime) || (hitBatch.m_peakTime[iHit] > hitFilter.m_maxPeakTime))
+        {
+            ++hitFilterCounters.m_nOutsideTickWindow;
+            continue;
+        }
+
+        if (hitFilter.m_useDriftVolumeXRange)
+        {
+            const unsigned int volumeID(hitBatch.m_volumeID[iHit]);
+
+            if ((volumeID < hitFilter.m_driftVolumeMinX.size()) && ((hitBatch.m_x[iHit] < hitFilter.m_driftVolumeMinX[volumeID]) ||
+                (hitBatch.m_x[iHit] > hitFilter.m_driftVolumeMaxX[volumeID])))
+            {
+                ++hitFilterCounters.m_nOutsideDriftVolume;
+                continue;
+            }
+        }
+
+        if (hitFilter.m_vetoBadChannels)
+        {
+            const raw::ChannelID_t channel(hitBatch.m_hits[iHit]->Channel());
+
+            if ((channel < hitFilter.m_isBadChannel.size()) && hitFilter.m_isBadChannel[channel])
+            {
+                ++hitFilterCounters.m_nBadChannel;
+                continue;
+            }
+        }
+
+        isAccepted[iHit] = true;
+        ++hitFilterCounters.m_nAccepted;
+    }
+
+    hitBatch.Compact(isAccepted);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 void LArPandoraInput::CreatePandoraLArTPCs(const Settings &settings, const LArDriftVolumeList &driftVolumeList)
 {
     mf::LogDebug("LArPandora") << " *** LArPandoraInput::CreatePandoraLArTPCs(...) *** " << std::endl;
@@ -251,10 +501,9 @@ void LArPandoraInput::CreatePandoraDetectorGaps(const Settings &settings, const
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandoraInput::CreatePandoraReadoutGaps(const Settings &settings, const LArDriftVolumeMap &driftVolumeMap)
+void LArPandoraInput::CreatePandoraReadoutGaps(const Settings &settings, const LArDriftVolumeMap &driftVolumeMap, const LArDetectorLookupTable &lookupTable,
+    const LArReadoutGapList &readoutGapList)
 {
-std::cout << "LArPandoraInput::CreatePandoraReadoutGaps" << std::endl;
-int nGaps(0);
     mf::LogDebug("LArPandora") << " *** LArPandoraInput::CreatePandoraReadoutGaps(...) *** " << std::endl;
 
     if (!settings.m_pPrimaryPandora)
@@ -262,121 +511,73 @@ int nGaps(0);
 
     const pandora::Pandora *pPandora(settings.m_pPrimaryPandora);
 
-    art::ServiceHandle<geo::Geometry> theGeometry;
-    const lariov::ChannelStatusProvider &channelStatus(art::ServiceHandle<lariov::ChannelStatusService>()->GetProvider());
-
-    for (unsigned int icstat = 0; icstat < theGeometry->Ncryostats(); ++icstat)
+    for (const LArReadoutGap &gap : readoutGapList)
     {
-        for (unsigned int itpc = 0; itpc < theGeometry->NTPC(icstat); ++itpc)
-        {
-            const geo::TPCGeo &TPC(theGeometry->TPC(itpc));
-
-            for (unsigned int iplane = 0; iplane < TPC.Nplanes(); ++iplane)
-            {
-                const geo::PlaneGeo &plane(TPC.Plane(iplane));
-                const float halfWirePitch(0.5f * theGeometry->WirePitch(plane.View()));
-                const unsigned int nWires(theGeometry->Nwires(geo::PlaneID(icstat, itpc, plane.View())));
-
-                int firstBadWire(-1), lastBadWire(-1);
-
-                for (unsigned int iwire = 0; iwire < nWires; ++iwire)
-                {
-                    const raw::ChannelID_t channel(theGeometry->PlaneWireToChannel(plane.View(), iwire, itpc, icstat));
-                    const bool isBadChannel(channelStatus.IsBad(channel));
-                    const bool isLastWire(nWires == (iwire + 1));
+        const LArPlaneLookup &plane(lookupTable.GetPlane(gap.GetCryostat(), gap.GetTpc(), gap.GetPlane()));
+        const LArDriftVolume &driftVolume(LArPandoraGeometry::GetDriftVolume(driftVolumeMap, gap.GetCryostat(), gap.GetTpc()));
 
-                    if (isBadChannel && (firstBadWire < 0))
-                        firstBadWire = iwire;
+        const float halfWirePitch(0.5f * plane.GetWirePitch());
+        const double firstY(plane.GetWireCenterY(gap.GetFirstWire())), firstZ(plane.GetWireCenterZ(gap.GetFirstWire()));
+        const double lastY(plane.GetWireCenterY(gap.GetLastWire())), lastZ(plane.GetWireCenterZ(gap.GetLastWire()));
 
-                    if (isBadChannel || isLastWire)
-                        lastBadWire = iwire;
-
-                    if (isBadChannel && !isLastWire)
-                        continue;
+        PandoraApi::Geometry::LineGap::Parameters parameters;
 
-                    if ((firstBadWire < 0) || (lastBadWire < 0))
-                        continue;
+        try
+        {
+            parameters.m_lineStartX = driftVolume.GetCenterX() - 0.5f * driftVolume.GetWidthX();
+            parameters.m_lineEndX = driftVolume.GetCenterX() + 0.5f * driftVolume.GetWidthX();
 
-                    double firstXYZ[3], lastXYZ[3];
-                    theGeometry->Cryostat(icstat).TPC(itpc).Plane(iplane).Wire(firstBadWire).GetCenter(firstXYZ);
-                    theGeometry->Cryostat(icstat).TPC(itpc).Plane(iplane).Wire(lastBadWire).GetCenter(lastXYZ);
+            const geo::View_t pandoraView(plane.GetGlobalView());
 
-                    firstBadWire = -1; lastBadWire = -1;
+            if (pandoraView == geo::kW)
+            {
+                const float firstW(firstZ);
+                const float lastW(lastZ);
 
-                    PandoraApi::Geometry::LineGap::Parameters parameters;
+                parameters.m_lineGapType = pandora::TPC_WIRE_GAP_VIEW_W;
+                parameters.m_lineStartZ = std::min(firstW, lastW) - halfWirePitch;
+                parameters.m_lineEndZ = std::max(firstW, lastW) + halfWirePitch;
+            }
+            else if (pandoraView == geo::kU)
+            {
+                const float firstU(pPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoU(firstY, firstZ));
+                const float lastU(pPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoU(lastY, lastZ));
 
-                    try
-                    {
-                        parameters.m_lineStartX = -std::numeric_limits<float>::max();
-                        parameters.m_lineEndX = std::numeric_limits<float>::max();
-
-                        const unsigned int volumeId(LArPandoraGeometry::GetVolumeID(driftVolumeMap, icstat, itpc));
-                        LArDriftVolumeMap::const_iterator volumeIter(driftVolumeMap.find(volumeId));
-
-                        if (driftVolumeMap.end() != volumeIter)
-                        {
-                            parameters.m_lineStartX = volumeIter->second.GetCenterX() - 0.5f * volumeIter->second.GetWidthX();
-                            parameters.m_lineEndX = volumeIter->second.GetCenterX() + 0.5f * volumeIter->second.GetWidthX();
-                        }
-
-                        const geo::View_t iview = (geo::View_t)iplane;
-                        const geo::View_t pandoraView(LArPandoraGeometry::GetGlobalView(icstat, itpc, iview));
-
-                        if (pandoraView == geo::kW)
-                        {
-                            const float firstW(firstXYZ[2]);
-                            const float lastW(lastXYZ[2]);
-
-                            parameters.m_lineGapType = pandora::TPC_WIRE_GAP_VIEW_W;
-                            parameters.m_lineStartZ = std::min(firstW, lastW) - halfWirePitch;
-                            parameters.m_lineEndZ = std::max(firstW, lastW) + halfWirePitch;
-                        }
-                        else if (pandoraView == geo::kU)
-                        {
-                            const float firstU(pPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoU(firstXYZ[1], firstXYZ[2]));
-                            const float lastU(pPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoU(lastXYZ[1], lastXYZ[2]));
-
-                            parameters.m_lineGapType = pandora::TPC_WIRE_GAP_VIEW_U;
-                            parameters.m_lineStartZ = std::min(firstU, lastU) - halfWirePitch;
-                            parameters.m_lineEndZ = std::max(firstU, lastU) + halfWirePitch;
-                        }
-                        else if (pandoraView == geo::kV)
-                        {
-                            const float firstV(pPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoV(firstXYZ[1], firstXYZ[2]));
-                            const float lastV(pPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoV(lastXYZ[1], lastXYZ[2]));
-
-                            parameters.m_lineGapType = pandora::TPC_WIRE_GAP_VIEW_V;
-                            parameters.m_lineStartZ = std::min(firstV, lastV) - halfWirePitch;
-                            parameters.m_lineEndZ = std::max(firstV, lastV) + halfWirePitch;
-                        }
-                    }
-                    catch (const pandora::StatusCodeException &)
-                    {
-                        mf::LogWarning("LArPandora") << "CreatePandoraReadoutGaps - invalid line gap parameter provided, all assigned values must be finite, line gap omitted " << std::endl;
-                        continue;
-                    }
+                parameters.m_lineGapType = pandora::TPC_WIRE_GAP_VIEW_U;
+                parameters.m_lineStartZ = std::min(firstU, lastU) - halfWirePitch;
+                parameters.m_lineEndZ = std::max(firstU, lastU) + halfWirePitch;
+            }
+            else if (pandoraView == geo::kV)
+            {
+                const float firstV(pPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoV(firstY, firstZ));
+                const float lastV(pPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoV(lastY, lastZ));
 
-                    try
-                    {
-                        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Geometry::LineGap::Create(*pPandora, parameters));
-nGaps++;
-                    }
-                    catch (const pandora::StatusCodeException &)
-                    {
-                        mf::LogWarning("LArPandora") << "CreatePandoraReadoutGaps - unable to create line gap, insufficient or invalid information supplied " << std::endl;
-                        continue;
-                    }
-                }
+                parameters.m_lineGapType = pandora::TPC_WIRE_GAP_VIEW_V;
+                parameters.m_lineStartZ = std::min(firstV, lastV) - halfWirePitch;
+                parameters.m_lineEndZ = std::max(firstV, lastV) + halfWirePitch;
             }
         }
+        catch (const pandora::StatusCodeException &)
+        {
+            mf::LogWarning("LArPandora") << "CreatePandoraReadoutGaps - invalid line gap parameter provided, all assigned values must be finite, line gap omitted " << std::endl;
+            continue;
+        }
+
+        try
+        {
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Geometry::LineGap::Create(*pPandora, parameters));
+        }
+        catch (const pandora::StatusCodeException &)
+        {
+            mf::LogWarning("LArPandora") << "CreatePandoraReadoutGaps - unable to create line gap, insufficient or invalid information supplied " << std::endl;
+            continue;
+        }
     }
-std::cout << "Number of gaps created : " << nGaps << std::endl;
-std::cout << "LArPandoraInput::CreatePandoraReadoutGaps - End" << std::endl;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandoraInput::CreatePandoraMCParticles(const Settings &settings, const MCTruthToMCParticles &truthToParticleMap,
+void LArPandoraInput::CreatePandoraMCParticles(const Settings &settings, const LArTpcGridIndex &tpcGridIndex, const MCTruthToMCParticles &truthToParticleMap,
     const MCParticlesToMCTruth &particleToTruthMap, const RawMCParticleVector &generatorMCParticleVector)
 {
     mf::LogDebug("LArPandora") << " *** LArPandoraInput::CreatePandoraMCParticles(...) *** " << std::endl;
@@ -385,6 +586,9 @@ void LArPandoraInput::CreatePandoraMCParticles(const Settings &settings, const M
     if (!settings.m_pPrimaryPandora)
         throw cet::exception("LArPandora") << "CreatePandoraMCParticles - primary Pandora instance does not exist ";
 
+    if (tpcGridIndex.IsEmpty())
+        throw cet::exception("LArPandora") << "CreatePandoraMCParticles - tpc grid index has not been loaded ";
+
     const pandora::Pandora *pPandora(settings.m_pPrimaryPandora);
 
     // Make indexed list of MC particles
@@ -399,7 +603,9 @@ void LArPandoraInput::CreatePandoraMCParticles(const Settings &settings, const M
     // Loop over MC truth objects
     int neutrinoCounter(0);
 
-    lar_content::LArMCParticleFactory mcParticleFactory;
+    lar_content::LArMCParticleFactory standardMCParticleFactory;
+    LArPooledMCParticleFactory pooledMCParticleFactory;
+    const lar_content::LArMCParticleFactory &mcParticleFactory(settings.m_usePooledInputObjects ? pooledMCParticleFactory : standardMCParticleFactory);
 
     for (MCTruthToMCParticles::const_iterator iter1 = truthToParticleMap.begin(), iterEnd1 = truthToParticleMap.end(); iter1 != iterEnd1; ++iter1)
     {
@@ -477,8 +683,8 @@ void LArPandoraInput::CreatePandoraMCParticles(const Settings &settings, const M
     int particleCounter(0);
 
     // Find Primary Generator Particles
-    std::map<const simb::MCParticle, bool> primaryGeneratorMCParticleMap;
-    LArPandoraInput::FindPrimaryParticles(generatorMCParticleVector, primaryGeneratorMCParticleMap);
+    PrimaryParticleIndex primaryParticleIndex;
+    LArPandoraInput::FindPrimaryParticles(generatorMCParticleVector, primaryParticleIndex);
 
     for (MCParticleMap::const_iterator iterI = particleMap.begin(), iterEndI = particleMap.end(); iterI != iterEndI; ++iterI)
     {
@@ -494,7 +700,7 @@ void LArPandoraInput::CreatePandoraMCParticles(const Settings &settings, const M
 
         // Find start and end trajectory points
         int firstT(-1), lastT(-1);
-        LArPandoraInput::GetTrueStartAndEndPoints(settings, particle, firstT, lastT);
+        LArPandoraInput::GetTrueStartAndEndPoints(tpcGridIndex, particle, firstT, lastT);
 
         if (firstT < 0 && lastT < 0)
         {
@@ -520,7 +726,7 @@ void LArPandoraInput::CreatePandoraMCParticles(const Settings &settings, const M
         const int trackID(particle->TrackId());
         const simb::Origin_t origin(particleInventoryService->TrackIdToMCTruth(trackID).Origin());
 
-        if (LArPandoraInput::IsPrimaryMCParticle(particle, primaryGeneratorMCParticleMap))
+        if (LArPandoraInput::IsPrimaryMCParticle(particle, primaryParticleIndex))
         {
             nuanceCode = 2001;
         }
@@ -587,37 +793,92 @@ void LArPandoraInput::CreatePandoraMCParticles(const Settings &settings, const M
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandoraInput::FindPrimaryParticles(const RawMCParticleVector &mcParticleVector, std::map<const simb::MCParticle, bool> &primaryMCParticleMap)  
+void LArPandoraInput::FindPrimaryParticles(const RawMCParticleVector &mcParticleVector, PrimaryParticleIndex &primaryParticleIndex)
 {
+    primaryParticleIndex.m_particles.clear();
+    primaryParticleIndex.m_isMatched.clear();
+    primaryParticleIndex.m_keyToParticles.clear();
+
     for (const simb::MCParticle &mcParticle : mcParticleVector)
     {
         if ("primary" == mcParticle.Process())
-        {
-            primaryMCParticleMap.emplace(std::make_pair(mcParticle, false));
-        }
+            primaryParticleIndex.m_particles.push_back(&mcParticle);
+    }
+
+    // ATTN Primary particles are considered in order of track id, keeping only the first particle with each track id
+    std::stable_sort(primaryParticleIndex.m_particles.begin(), primaryParticleIndex.m_particles.end(),
+        [](const simb::MCParticle *const pLhs, const simb::MCParticle *const pRhs) {return (pLhs->TrackId() < pRhs->TrackId());});
+
+    primaryParticleIndex.m_particles.erase(std::unique(primaryParticleIndex.m_particles.begin(), primaryParticleIndex.m_particles.end(),
+        [](const simb::MCParticle *const pLhs, const simb::MCParticle *const pRhs) {return (pLhs->TrackId() == pRhs->TrackId());}),
+        primaryParticleIndex.m_particles.end());
+
+    primaryParticleIndex.m_isMatched.assign(primaryParticleIndex.m_particles.size(), false);
+
+    for (unsigned int index = 0; index < primaryParticleIndex.m_particles.size(); ++index)
+    {
+        const simb::MCParticle *const pMCParticle(primaryParticleIndex.m_particles.at(index));
+        primaryParticleIndex.m_keyToParticles[LArPandoraInput::GetMomentumKey(pMCParticle->Px(), pMCParticle->Py(), pMCParticle->Pz())].push_back(index);
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-bool LArPandoraInput::IsPrimaryMCParticle(const art::Ptr<simb::MCParticle> &mcParticle, std::map<const simb::MCParticle, bool> &primaryMCParticleMap) 
+bool LArPandoraInput::IsPrimaryMCParticle(const art::Ptr<simb::MCParticle> &mcParticle, PrimaryParticleIndex &primaryParticleIndex)
 {
-    for (auto &mcParticleIter : primaryMCParticleMap)
+    const double epsilon(std::numeric_limits<double>::epsilon());
+    const double px(mcParticle->Px()), py(mcParticle->Py()), pz(mcParticle->Pz());
+
+    // A matching momentum can only lie in the cells spanned by the matching tolerance, typically just a single cell
+    const PrimaryParticleIndex::MomentumKey lowKey(LArPandoraInput::GetMomentumKey(px - epsilon, py - epsilon, pz - epsilon));
+    const PrimaryParticleIndex::MomentumKey highKey(LArPandoraInput::GetMomentumKey(px + epsilon, py + epsilon, pz + epsilon));
+
+    int bestIndex(-1);
+
+    for (long long kx = lowKey[0]; kx <= highKey[0]; ++kx)
     {
-        if (!mcParticleIter.second)
+        for (long long ky = lowKey[1]; ky <= highKey[1]; ++ky)
         {
-            const simb::MCParticle primaryMCParticle(mcParticleIter.first);
-
-            if (std::fabs(primaryMCParticle.Px() - mcParticle->Px()) < std::numeric_limits<double>::epsilon() && 
-                std::fabs(primaryMCParticle.Py() - mcParticle->Py()) < std::numeric_limits<double>::epsilon() && 
-                std::fabs(primaryMCParticle.Pz() - mcParticle->Pz()) < std::numeric_limits<double>::epsilon())
+            for (long long kz = lowKey[2]; kz <= highKey[2]; ++kz)
             {
-                mcParticleIter.second = true;
-                return true;
+                PrimaryParticleIndex::MomentumKeyToParticles::const_iterator iter(primaryParticleIndex.m_keyToParticles.find({{kx, ky, kz}}));
+
+                if (primaryParticleIndex.m_keyToParticles.end() == iter)
+                    continue;
+
+                for (const unsigned int index : iter->second)
+                {
+                    if (primaryParticleIndex.m_isMatched.at(index) || ((bestIndex >= 0) && (static_cast<int>(index) > bestIndex)))
+                        continue;
+
+                    const simb::MCParticle *const pPrimaryMCParticle(primaryParticleIndex.m_particles.at(index));
+
+                    if (std::fabs(pPrimaryMCParticle->Px() - px) < epsilon && std::fabs(pPrimaryMCParticle->Py() - py) < epsilon &&
+                        std::fabs(pPrimaryMCParticle->Pz() - pz) < epsilon)
+                    {
+                        bestIndex = static_cast<int>(index);
+                    }
+                }
             }
         }
     }
-    return false;
+
+    if (bestIndex < 0)
+        return false;
+
+    primaryParticleIndex.m_isMatched.at(bestIndex) = true;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArPandoraInput::PrimaryParticleIndex::MomentumKey LArPandoraInput::GetMomentumKey(const double px, const double py, const double pz)
+{
+    // Momentum cells of 1 keV/c, which is far coarser than the matching tolerance
+    const double cellSize(1.e-6);
+
+    return {{static_cast<long long>(std::floor(px / cellSize)), static_cast<long long>(std::floor(py / cellSize)),
+        static_cast<long long>(std::floor(pz / cellSize))}};
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -629,13 +890,10 @@ void LArPandoraInput::CreatePandoraMCLinks2D(const Settings &settings, const IdT
     if (!settings.m_pPrimaryPandora)
         throw cet::exception("LArPandora") << "CreatePandoraMCLinks2D - primary Pandora instance does not exist ";
 
-    const pandora::Pandora *pPandora(settings.m_pPrimaryPandora);
-
     for (IdToHitMap::const_iterator iterI = idToHitMap.begin(), iterEndI = idToHitMap.end(); iterI != iterEndI ; ++iterI)
     {
         const int hitID(iterI->first);
         const art::Ptr<recob::Hit> hit(iterI->second);
-      //  const geo::WireID hit_WireID(hit->WireID());
 
         // Get list of associated MC particles
         HitsToTrackIDEs::const_iterator iterJ = hitToParticleMap.find(hit);
@@ -648,23 +906,49 @@ void LArPandoraInput::CreatePandoraMCLinks2D(const Settings &settings, const IdT
         if (trackCollection.size() == 0)
             throw cet::exception("LArPandora") << "CreatePandoraMCLinks2D - found a hit without any associated MC truth information ";
 
-        // Create links between hits and MC particles
-        for (unsigned int k = 0; k < trackCollection.size(); ++k)
-        {
-            const sim::TrackIDE trackIDE(trackCollection.at(k));
-            const int trackID(std::abs(trackIDE.trackID)); // TODO: Find out why std::abs is needed
-            const float energyFrac(trackIDE.energyFrac);
+        LArPandoraInput::CreatePandoraMCLinks(settings, hitID, trackCollection.begin(), trackCollection.end());
+    }
+}
 
-            try
-            {
-                PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetCaloHitToMCParticleRelationship(*pPandora,
-                    (void*)((intptr_t)hitID), (void*)((intptr_t)trackID), energyFrac));
-            }
-            catch (const pandora::StatusCodeException &)
-            {
-                mf::LogWarning("LArPandora") << "CreatePandoraMCLinks2D - unable to create calo hit to mc particle relationship, invalid information supplied " << std::endl;
-                continue;
-            }
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInput::CreatePandoraMCLinks2D(const Settings &settings, const IdToHitMap &idToHitMap, const HitTrackIDETable &hitTrackIDETable)
+{
+    mf::LogDebug("LArPandora") << " *** LArPandoraInput::CreatePandoraMCLinks(...) *** " << std::endl;
+
+    if (!settings.m_pPrimaryPandora)
+        throw cet::exception("LArPandora") << "CreatePandoraMCLinks2D - primary Pandora instance does not exist ";
+
+    for (IdToHitMap::const_iterator iterI = idToHitMap.begin(), iterEndI = idToHitMap.end(); iterI != iterEndI ; ++iterI)
+    {
+        const HitTrackIDETable::TrackIDERange trackRange(hitTrackIDETable.GetTrackIDEs(iterI->second));
+        LArPandoraInput::CreatePandoraMCLinks(settings, iterI->first, trackRange.first, trackRange.second);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInput::CreatePandoraMCLinks(const Settings &settings, const int hitID, const TrackIDEVector::const_iterator &begin,
+    const TrackIDEVector::const_iterator &end)
+{
+    const pandora::Pandora *pPandora(settings.m_pPrimaryPandora);
+
+    // Create links between hits and MC particles
+    for (TrackIDEVector::const_iterator iter = begin; iter != end; ++iter)
+    {
+        const sim::TrackIDE &trackIDE(*iter);
+        const int trackID(std::abs(trackIDE.trackID)); // TODO: Find out why std::abs is needed
+        const float energyFrac(trackIDE.energyFrac);
+
+        try
+        {
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetCaloHitToMCParticleRelationship(*pPandora,
+                (void*)((intptr_t)hitID), (void*)((intptr_t)trackID), energyFrac));
+        }
+        catch (const pandora::StatusCodeException &)
+        {
+            mf::LogWarning("LArPandora") << "CreatePandoraMCLinks2D - unable to create calo hit to mc particle relationship, invalid information supplied " << std::endl;
+            continue;
         }
     }
 }
@@ -717,103 +1001,74 @@ std::cout << "7" << std::endl;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandoraInput::GetTrueStartAndEndPoints(const Settings &settings, const art::Ptr<simb::MCParticle> &particle, int &firstT, int &lastT)
+void LArPandoraInput::GetTrueStartAndEndPoints(const LArTpcGridIndex &tpcGridIndex, const art::Ptr<simb::MCParticle> &particle, int &firstT, int &lastT)
 {
-    art::ServiceHandle<geo::Geometry> theGeometry;
     firstT = -1;  lastT  = -1;
 
-    for (unsigned int icstat = 0; icstat < theGeometry->Ncryostats(); ++icstat)
-    {
-        for (unsigned int itpc = 0; itpc < theGeometry->NTPC(icstat); ++itpc)
-        {
-            int thisfirstT(-1), thislastT(-1);
-            LArPandoraInput::GetTrueStartAndEndPoints(icstat, itpc, particle, thisfirstT, thislastT);
-
-            if (thisfirstT < 0)
-                continue;
-
-            if (firstT < 0 || thisfirstT < firstT)
-                firstT = thisfirstT;
-
-            if (lastT < 0 || thislastT > lastT)
-                lastT = thislastT;
-        }
-    }
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-
-void LArPandoraInput::GetTrueStartAndEndPoints(const unsigned int cstat, const unsigned int tpc, const art::Ptr<simb::MCParticle> &particle,
-    int &startT, int &endT)
-{
-    art::ServiceHandle<geo::Geometry> theGeometry;
-
-    bool foundStartPosition(false);
     const int numTrajectoryPoints(static_cast<int>(particle->NumberTrajectoryPoints()));
 
     for (int nt = 0; nt < numTrajectoryPoints; ++nt)
     {
-        const double pos[3] = {particle->Vx(nt), particle->Vy(nt), particle->Vz(nt)};
-        geo::TPCID tpcID = theGeometry->FindTPCAtPosition(pos);
-
-        if (!tpcID.isValid)
+        if (!tpcGridIndex.FindTpc(particle->Vx(nt), particle->Vy(nt), particle->Vz(nt)))
             continue;
 
-        if (!(cstat == tpcID.Cryostat && tpc == tpcID.TPC))
-            continue;
+        if (firstT < 0)
+            firstT = nt;
 
-        endT = nt;
-
-        if (!foundStartPosition)
-        {
-            startT = endT;
-            foundStartPosition = true;
-        }
+        lastT = nt;
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-float LArPandoraInput::GetTrueX0(const art::Ptr<simb::MCParticle> &particle, const int nt)
+float LArPandoraInput::GetTrueX0(const LArTpcGridIndex &tpcGridIndex, const art::Ptr<simb::MCParticle> &particle, const int nt)
 {
-    art::ServiceHandle<geo::Geometry> theGeometry;
     auto const* theTime = lar::providerFrom<detinfo::DetectorClocksService>();
     auto const* theDetector = lar::providerFrom<detinfo::DetectorPropertiesService>();
 
-    unsigned int which_tpc(0);
-    unsigned int which_cstat(0);
-    double pos[3] = {particle->Vx(nt), particle->Vy(nt), particle->Vz(nt)};
-    theGeometry->PositionToTPC(pos, which_tpc, which_cstat);
+    const LArTpcBox *const pTpcBox(tpcGridIndex.FindTpc(particle->Vx(nt), particle->Vy(nt), particle->Vz(nt)));
+
+    if (!pTpcBox)
+        throw cet::exception("LArPandora") << "GetTrueX0 - trajectory point is not within any tpc ";
 
     const float vtxT(particle->T(nt));
     const float vtxTDC(theTime->TPCG4Time2Tick(vtxT));
     const float vtxTDC0(theDetector->TriggerOffset());
 
-    const geo::TPCGeo &theTpc = theGeometry->Cryostat(which_cstat).TPC(which_tpc);
-    const float driftDir((theTpc.DriftDirection() == geo::kNegX) ? +1.0 :-1.0);
+    const float driftDir(pTpcBox->IsNegativeDrift() ? +1.0 :-1.0);
     return (driftDir * (vtxTDC - vtxTDC0) * theDetector->GetXTicksCoefficient());
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-double LArPandoraInput::GetMips(const Settings &settings, const double hit_Charge, const geo::View_t hit_View)
+unsigned int LArPandoraInput::GetViewIndex(const geo::View_t pandora_View)
 {
-    art::ServiceHandle<geo::Geometry> theGeometry;
-    auto const* theDetector = lar::providerFrom<detinfo::DetectorPropertiesService>();
+    if (pandora_View == geo::kU)
+        return 0;
 
-    // TODO: Unite this procedure with other calorimetry procedures under development
-    const double dQdX(hit_Charge / (theGeometry->WirePitch(hit_View))); // ADC/cm
-    const double dQdX_e(dQdX / (theDetector->ElectronsToADC() * settings.m_recombination_factor)); // e/cm
-    const double dEdX(settings.m_useBirksCorrection ? theDetector->BirksCorrection(dQdX_e) : dQdX_e * 1000. / util::kGeVToElectrons); // MeV/cm
-    double mips(dEdX / settings.m_dEdX_mip);
+    if (pandora_View == geo::kV)
+        return 1;
 
-    if (mips < 0.)
-        mips = settings.m_mips_if_negative;
+    if (pandora_View == geo::kW)
+        return 2;
 
-    if (mips > settings.m_mips_max)
-        mips = settings.m_mips_max;
+    throw cet::exception("LArPandora") << "GetViewIndex - this wire view not recognised (View=" << pandora_View << ") ";
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+double LArPandoraInput::ProjectYZ(const pandora::LArTransformationPlugin *const pTransform, const geo::View_t pandora_View, const double y, const double z)
+{
+    if (pandora_View == geo::kU)
+        return pTransform->YZtoU(y, z);
+
+    if (pandora_View == geo::kV)
+        return pTransform->YZtoV(y, z);
 
-    return mips;
+    if (pandora_View == geo::kW)
+        return pTransform->YZtoW(y, z);
+
+    throw cet::exception("LArPandora") << "ProjectYZ - this wire view not recognised (View=" << pandora_View << ") ";
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -831,8 +1086,175 @@ LArPandoraInput::Settings::Settings() :
     m_mips_max(50.),
     m_mips_if_negative(0.),
     m_mips_to_gev(3.5e-4),
-    m_recombination_factor(0.63)
+    m_recombination_factor(0.63),
+    m_birksTableMaxDQdX(5.e5),
+    m_birksTableNodes(5001),
+    m_usePooledInputObjects(false)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArPandoraInput::HitConversionConstants::HitConversionConstants() :
+    m_projectionOrigin{0., 0., 0.},
+    m_projectionY{0., 0., 0.},
+    m_projectionZ{0., 0., 0.},
+    m_electronsToADC(1.),
+    m_adcToElectrons(1.),
+    m_electronsToMips(1.),
+    m_birksTableMaxDQdX(0.),
+    m_birksTableInverseStep(0.),
+    m_birksTableMaxPosition(0.)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+size_t LArPandoraInput::PrimaryParticleIndex::MomentumKeyHash::operator()(const MomentumKey &key) const
+{
+    size_t hash(std::hash<long long>()(key[0]));
+    hash ^= std::hash<long long>()(key[1]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<long long>()(key[2]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInput::HitBatch::Clear()
+{
+    m_hits.clear();
+    m_hitType.clear();
+    m_viewIndex.clear();
+    m_volumeID.clear();
+    m_peakTime.clear();
+    m_timeStart.clear();
+    m_timeEnd.clear();
+    m_integral.clear();
+    m_tickToXOffset.clear();
+    m_tickToXSlope.clear();
+    m_wireY.clear();
+    m_wireZ.clear();
+    m_wirePitch.clear();
+    m_x.clear();
+    m_dx.clear();
+    m_projection.clear();
+    m_mips.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInput::HitBatch::Reserve(const size_t nHits)
+{
+    m_hits.reserve(nHits);
+    m_hitType.reserve(nHits);
+    m_viewIndex.reserve(nHits);
+    m_volumeID.reserve(nHits);
+    m_peakTime.reserve(nHits);
+    m_timeStart.reserve(nHits);
+    m_timeEnd.reserve(nHits);
+    m_integral.reserve(nHits);
+    m_tickToXOffset.reserve(nHits);
+    m_tickToXSlope.reserve(nHits);
+    m_wireY.reserve(nHits);
+    m_wireZ.reserve(nHits);
+    m_wirePitch.reserve(nHits);
+    m_x.reserve(nHits);
+    m_dx.reserve(nHits);
+    m_projection.reserve(nHits);
+    m_mips.reserve(nHits);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+void LArPandoraInput::HitBatch::CompactBuffer(const std::vector<bool> &isAccepted, std::vector<T> &buffer)
+{
+    size_t nAccepted(0);
+
+    for (size_t iHit = 0, nHits = buffer.size(); iHit < nHits; ++iHit)
+    {
+        if (!isAccepted[iHit])
+            continue;
+
+        if (nAccepted != iHit)
+            buffer[nAccepted] = std::move(buffer[iHit]);
+
+        ++nAccepted;
+    }
+
+    buffer.resize(nAccepted);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInput::HitBatch::Compact(const std::vector<bool> &isAccepted)
+{
+    if (isAccepted.size() != this->Size())
+        throw cet::exception("LArPandora") << "HitBatch::Compact - acceptance flags do not match hit batch size ";
+
+    if (std::find(isAccepted.begin(), isAccepted.end(), false) == isAccepted.end())
+        return;
+
+    CompactBuffer(isAccepted, m_hits);
+    CompactBuffer(isAccepted, m_hitType);
+    CompactBuffer(isAccepted, m_viewIndex);
+    CompactBuffer(isAccepted, m_volumeID);
+    CompactBuffer(isAccepted, m_peakTime);
+    CompactBuffer(isAccepted, m_timeStart);
+    CompactBuffer(isAccepted, m_timeEnd);
+    CompactBuffer(isAccepted, m_integral);
+    CompactBuffer(isAccepted, m_tickToXOffset);
+    CompactBuffer(isAccepted, m_tickToXSlope);
+    CompactBuffer(isAccepted, m_wireY);
+    CompactBuffer(isAccepted, m_wireZ);
+    CompactBuffer(isAccepted, m_wirePitch);
+    CompactBuffer(isAccepted, m_x);
+    CompactBuffer(isAccepted, m_dx);
+    CompactBuffer(isAccepted, m_projection);
+    CompactBuffer(isAccepted, m_mips);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArPandoraInput::HitFilter::HitFilter() :
+    m_minIntegral(-std::numeric_limits<double>::max()),
+    m_minPeakTime(-std::numeric_limits<double>::max()),
+    m_maxPeakTime(std::numeric_limits<double>::max()),
+    m_useDriftVolumeXRange(false),
+    m_vetoBadChannels(false)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArPandoraInput::HitFilterCounters::HitFilterCounters() :
+    m_nInput(0),
+    m_nNonFinite(0),
+    m_nBelowMinIntegral(0),
+    m_nOutsideTickWindow(0),
+    m_nOutsideDriftVolume(0),
+    m_nBadChannel(0),
+    m_nAccepted(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArPandoraInput::HitFilterCounters &LArPandoraInput::HitFilterCounters::operator+=(const HitFilterCounters &rhs)
 {
+    m_nInput += rhs.m_nInput;
+    m_nNonFinite += rhs.m_nNonFinite;
+    m_nBelowMinIntegral += rhs.m_nBelowMinIntegral;
+    m_nOutsideTickWindow += rhs.m_nOutsideTickWindow;
+    m_nOutsideDriftVolume += rhs.m_nOutsideDriftVolume;
+    m_nBadChannel += rhs.m_nBadChannel;
+    m_nAccepted += rhs.m_nAccepted;
+    return *this;
 }
 
 } // namespace lar_pandora
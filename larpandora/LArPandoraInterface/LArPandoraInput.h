@@ -9,10 +9,20 @@
 
 #include "lardata/ArtDataHelper/MVAReader.h"
 
+#include "Pandora/PandoraEnumeratedTypes.h"
+
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+
 #include "larpandora/LArPandoraInterface/ILArPandora.h"
 #include "larpandora/LArPandoraInterface/LArPandoraHelper.h"
 #include "larpandora/LArPandoraInterface/LArPandoraGeometry.h"
 
+namespace pandora {class LArTransformationPlugin;}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 namespace lar_pandora
 {
 
@@ -45,17 +55,238 @@ public:
         double                  m_mips_if_negative;         ///<
         double                  m_mips_to_gev;              ///<
         double                  m_recombination_factor;     ///<
+        double                  m_birksTableMaxDQdX;        ///< The upper edge of the tabulated Birks correction (electrons per cm)
+        unsigned int            m_birksTableNodes;          ///< The number of nodes in the tabulated Birks correction (fewer than two to disable)
+        bool                    m_usePooledInputObjects;    ///< Whether to create the calo hits and mc particles in pools that recycle storage across events
+    };
+
+    /**
+     *  @brief  HitConversionConstants class, holding the per-event constants required by the batched hit conversion
+     */
+    class HitConversionConstants
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        HitConversionConstants();
+
+        double                  m_projectionOrigin[3];      ///< The u, v, w coordinates at (y, z) = (0, 0)
+        double                  m_projectionY[3];           ///< The change in u, v, w coordinates per unit y
+        double                  m_projectionZ[3];           ///< The change in u, v, w coordinates per unit z
+        double                  m_electronsToADC;           ///< The conversion from electrons to ADC counts
+        double                  m_adcToElectrons;           ///< The conversion from ADC counts to electrons, corrected for recombination
+        double                  m_electronsToMips;          ///< The conversion from electrons per cm to mips, if not applying Birks correction
+        double                  m_birksTableMaxDQdX;        ///< The upper edge of the tabulated Birks correction (electrons per cm)
+        double                  m_birksTableInverseStep;    ///< The inverse of the node spacing in the tabulated Birks correction
+        double                  m_birksTableMaxPosition;    ///< The position of the last node in the tabulated Birks correction
+        std::vector<double>     m_birksTable;               ///< The Birks-corrected mips at equally spaced dQ/dx nodes from zero, plus one padding node
+
+        /**
+         *  @brief  Evaluate the tabulated Birks correction, by linear interpolation between nodes
+         *
+         *  @param  dQdX the charge per unit length (electrons per cm), which must lie within [0, m_birksTableMaxDQdX] for a meaningful result
+         *
+         *  @return the mip equivalent charge
+         */
+        double GetTabulatedMips(const double dQdX) const;
+    };
+
+    /**
+     *  @brief  HitBatch class, holding structure-of-arrays buffers for the batched conversion of ART hits to Pandora hits
+     */
+    class HitBatch
+    {
+    public:
+        /**
+         *  @brief  Clear all buffers, retaining their capacity
+         */
+        void Clear();
+
+        /**
+         *  @brief  Reserve capacity in all buffers
+         *
+         *  @param  nHits the number of hits
+         */
+        void Reserve(const size_t nHits);
+
+        /**
+         *  @brief  Get the number of hits in the batch
+         */
+        size_t Size() const;
+
+        /**
+         *  @brief  Remove the rejected hits from all buffers, preserving the order of the accepted hits
+         *
+         *  @param  isAccepted whether each hit is accepted
+         */
+        void Compact(const std::vector<bool> &isAccepted);
+
+        HitVector                       m_hits;             ///< The input ART hits
+        std::vector<pandora::HitType>   m_hitType;          ///< The pandora hit type (global view)
+        std::vector<unsigned char>      m_viewIndex;        ///< The index of the global view (u = 0, v = 1, w = 2)
+        std::vector<unsigned int>       m_volumeID;         ///< The drift volume id
+        std::vector<double>             m_peakTime;         ///< The hit peak time (ticks)
+        std::vector<double>             m_timeStart;        ///< The hit peak time minus rms (ticks)
+        std::vector<double>             m_timeEnd;          ///< The hit peak time plus rms (ticks)
+        std::vector<double>             m_integral;         ///< The hit integral (ADC)
+        std::vector<double>             m_tickToXOffset;    ///< The x coordinate at tick zero for the hit plane
+        std::vector<double>             m_tickToXSlope;     ///< The change in x coordinate per tick for the hit plane
+        std::vector<double>             m_wireY;            ///< The y coordinate of the centre of the hit wire
+        std::vector<double>             m_wireZ;            ///< The z coordinate of the centre of the hit wire
+        std::vector<double>             m_wirePitch;        ///< The wire pitch of the hit plane
+
+        std::vector<double>             m_x;                ///< Output: the hit x coordinate
+        std::vector<double>             m_dx;               ///< Output: the hit width in x
+        std::vector<double>             m_projection;       ///< Output: the hit wire coordinate in the pandora u, v or w view
+        std::vector<double>             m_mips;             ///< Output: the hit charge in mip equivalents
+
+    private:
+        /**
+         *  @brief  Remove the rejected hits from a single buffer, preserving the order of the accepted hits
+         *
+         *  @param  isAccepted whether each hit is accepted
+         *  @param  buffer the buffer
+         */
+        template <typename T>
+        static void CompactBuffer(const std::vector<bool> &isAccepted, std::vector<T> &buffer);
+    };
+
+    /**
+     *  @brief  HitFilter class, holding the cuts applied to the ART hits before they are passed to pandora
+     */
+    class HitFilter
+    {
+    public:
+        /**
+         *  @brief  Default constructor, all optional cuts disabled
+         */
+        HitFilter();
+
+        double                  m_minIntegral;              ///< The minimum hit integral (ADC)
+        double                  m_minPeakTime;              ///< The minimum hit peak time (ticks)
+        double                  m_maxPeakTime;              ///< The maximum hit peak time (ticks)
+        bool                    m_useDriftVolumeXRange;     ///< Whether to require hits to lie within the x extent of their drift volume
+        std::vector<double>     m_driftVolumeMinX;          ///< The minimum x coordinate for each drift volume, indexed by volume id
+        std::vector<double>     m_driftVolumeMaxX;          ///< The maximum x coordinate for each drift volume, indexed by volume id
+        bool                    m_vetoBadChannels;          ///< Whether to reject hits on bad channels
+        std::vector<bool>       m_isBadChannel;             ///< Whether each channel is bad, indexed by channel id
+    };
+
+    /**
+     *  @brief  HitFilterCounters class, counting the hits rejected by the hit filter for each reason
+     */
+    class HitFilterCounters
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        HitFilterCounters();
+
+        /**
+         *  @brief  Add the counts from another set of counters
+         *
+         *  @param  rhs the other counters
+         */
+        HitFilterCounters &operator+=(const HitFilterCounters &rhs);
+
+        size_t                  m_nInput;                   ///< The number of hits considered
+        size_t                  m_nNonFinite;               ///< The number of hits rejected due to non-finite parameters
+        size_t                  m_nBelowMinIntegral;        ///< The number of hits rejected due to the integral threshold
+        size_t                  m_nOutsideTickWindow;       ///< The number of hits rejected due to the peak time window
+        size_t                  m_nOutsideDriftVolume;      ///< The number of hits rejected due to the drift volume x range
+        size_t                  m_nBadChannel;              ///< The number of hits rejected due to the bad channel veto
+        size_t                  m_nAccepted;                ///< The number of hits accepted
+    };
+
+    /**
+     *  @brief  PrimaryParticleIndex class, a hashed index of primary generator particles keyed on quantised momentum
+     */
+    class PrimaryParticleIndex
+    {
+    public:
+        typedef std::array<long long, 3> MomentumKey;
+
+        /**
+         *  @brief  MomentumKeyHash class, hash function for momentum keys
+         */
+        class MomentumKeyHash
+        {
+        public:
+            size_t operator()(const MomentumKey &key) const;
+        };
+
+        typedef std::unordered_map<MomentumKey, std::vector<unsigned int>, MomentumKeyHash> MomentumKeyToParticles;
+
+        std::vector<const simb::MCParticle*>    m_particles;            ///< The primary particles (addresses only), ordered by track id
+        std::vector<bool>                       m_isMatched;            ///< Whether each primary particle has already been matched
+        MomentumKeyToParticles                  m_keyToParticles;       ///< The indices of the primary particles in each momentum cell
     };
 
     /**
      *  @brief  Create the Pandora 2D hits from the ART hits
      *
      *  @param  settings the settings
-     *  @param  driftVolumeMap the mapping from volume id to drift volume
+     *  @param  lookupTable the precomputed per-plane wire positions, wire pitches and tick to x conversions
      *  @param  hits the input list of ART hits for this event
      *  @param  idToHitMap to receive the mapping from Pandora hit ID to ART hit
      */
-    static void CreatePandoraHits2D(const Settings &settings, const LArDriftVolumeMap &driftVolumeMap, const HitVector &hitVector, IdToHitMap &idToHitMap);
+    static void CreatePandoraHits2D(const Settings &settings, const LArDetectorLookupTable &lookupTable, const HitVector &hitVector, IdToHitMap &idToHitMap);
+
+    /**
+     *  @brief  Create the Pandora 2D hits from an already converted and filtered hit batch
+     *
+     *  @param  settings the settings
+     *  @param  hitBatch the converted and filtered hit batch
+     *  @param  idToHitMap to receive the mapping from Pandora hit ID to ART hit
+     */
+    static void CreatePandoraHits2D(const Settings &settings, const HitBatch &hitBatch, IdToHitMap &idToHitMap);
+
+    /**
+     *  @brief  Extract the per-event hit conversion constants, including the (linear) view projections from the transformation plugin
+     *
+     *  @param  settings the settings
+     *  @param  constants to receive the hit conversion constants
+     */
+    static void LoadHitConversionConstants(const Settings &settings, HitConversionConstants &constants);
+
+    /**
+     *  @brief  Get the largest deviation of the tabulated Birks correction from the exact calculation, evaluated midway between nodes
+     *
+     *  @param  settings the settings
+     *  @param  constants the hit conversion constants
+     *
+     *  @return the largest deviation, in mips
+     */
+    static double GetBirksTableMaxDeviation(const Settings &settings, const HitConversionConstants &constants);
+
+    /**
+     *  @brief  Gather the ART hits, and their plane properties, into a hit batch
+     *
+     *  @param  lookupTable the precomputed per-plane wire positions, wire pitches and tick to x conversions
+     *  @param  hitVector the input list of ART hits for this event
+     *  @param  hitBatch to receive the gathered hit properties
+     */
+    static void FillHitBatch(const LArDetectorLookupTable &lookupTable, const HitVector &hitVector, HitBatch &hitBatch);
+
+    /**
+     *  @brief  Calculate the x coordinates, widths, projected wire coordinates and mip equivalents for a hit batch
+     *
+     *  @param  settings the settings
+     *  @param  constants the hit conversion constants
+     *  @param  hitBatch the hit batch, to receive the outputs
+     */
+    static void ConvertHitBatch(const Settings &settings, const HitConversionConstants &constants, HitBatch &hitBatch);
+
+    /**
+     *  @brief  Remove hits with non-finite parameters, and hits failing the configured cuts, from a converted hit batch
+     *
+     *  @param  hitFilter the hit filter
+     *  @param  hitBatch the converted hit batch, from which rejected hits are removed
+     *  @param  hitFilterCounters to receive the numbers of hits rejected for each reason
+     */
+    static void FilterHitBatch(const HitFilter &hitFilter, HitBatch &hitBatch, HitFilterCounters &hitFilterCounters);
 
     /**
      *  @brief  Create pandora LArTPCs to represent the different drift volumes in use
@@ -80,43 +311,56 @@ public:
      *
      *  @param  settings the settings
      *  @param  driftVolumeMap the mapping from volume id to drift volume
+     *  @param  lookupTable the precomputed per-plane wire positions, wire pitches and tick to x conversions
+     *  @param  readoutGapList the list of continuous regions of bad wires
      */
-    static void CreatePandoraReadoutGaps(const Settings &settings, const LArDriftVolumeMap &driftVolumeMap);
+    static void CreatePandoraReadoutGaps(const Settings &settings, const LArDriftVolumeMap &driftVolumeMap, const LArDetectorLookupTable &lookupTable,
+        const LArReadoutGapList &readoutGapList);
 
     /**
      *  @brief  Create the Pandora MC particles from the MC particles
      *
      *  @param  settings the settings
+     *  @param  tpcGridIndex the grid index of tpc bounding boxes
      *  @param  truthToParticles  mapping from MC truth to MC particles
      *  @param  particlesToTruth  mapping from MC particles to MC truth
      */
-    static void CreatePandoraMCParticles(const Settings &settings, const MCTruthToMCParticles &truthToParticles,
+    static void CreatePandoraMCParticles(const Settings &settings, const LArTpcGridIndex &tpcGridIndex, const MCTruthToMCParticles &truthToParticles,
         const MCParticlesToMCTruth &particlesToTruth, const RawMCParticleVector &generatorMCParticleVector);
 
     /**
      *  @brief Find all primary MCParticles in a given vector of MCParticles
      *
-     *  @param mcParticleVector vector of all MCParticles to consider
-     *  @param primaryMCParticleMap map containing primary MCParticles and bool indicating whether particle has been accounted for
+     *  @param mcParticleVector vector of all MCParticles to consider, which must outlive the index
+     *  @param primaryParticleIndex to receive the index of primary MCParticles
      */
-    static void FindPrimaryParticles(const RawMCParticleVector &mcParticleVector, std::map<const simb::MCParticle, bool> &primaryMCParticleMap);
+    static void FindPrimaryParticles(const RawMCParticleVector &mcParticleVector, PrimaryParticleIndex &primaryParticleIndex);
 
     /**
-     *  @brief Check whether an MCParticle can be found in a given map
+     *  @brief Check whether an MCParticle matches (in momentum) a primary MCParticle not yet accounted for, and if so mark it as accounted for
      *
      *  @param mcParticle target MCParticle
-     *  @param primaryMCParticleMap map containing primary MCParticles and bool indicating whether particle has been accounted for
+     *  @param primaryParticleIndex the index of primary MCParticles
      */
-    static bool IsPrimaryMCParticle(const art::Ptr<simb::MCParticle> &mcParticle, std::map<const simb::MCParticle, bool> &primaryMCParticleMap);
+    static bool IsPrimaryMCParticle(const art::Ptr<simb::MCParticle> &mcParticle, PrimaryParticleIndex &primaryParticleIndex);
 
     /**
      *  @brief  Create links between the 2D hits and Pandora MC particles
      *
      *  @param  settings the settings
-     *  @param  hitMap mapping from Pandora hit addresses to ART hits
+     *  @param  idToHitMap mapping from Pandora hit ID to ART hit
      *  @param  hitToParticleMap mapping from each ART hit to its underlying G4 track ID
      */
-    static void CreatePandoraMCLinks2D(const Settings &settings, const HitMap &hitMap, const HitsToTrackIDEs &hitToParticleMap);
+    static void CreatePandoraMCLinks2D(const Settings &settings, const IdToHitMap &idToHitMap, const HitsToTrackIDEs &hitToParticleMap);
+
+    /**
+     *  @brief  Create links between the 2D hits and Pandora MC particles
+     *
+     *  @param  settings the settings
+     *  @param  idToHitMap mapping from Pandora hit ID to ART hit
+     *  @param  hitTrackIDETable table of the true energy deposits for each ART hit
+     */
+    static void CreatePandoraMCLinks2D(const Settings &settings, const IdToHitMap &idToHitMap, const HitTrackIDETable &hitTrackIDETable);
 
     /**
      *  @brief  Create a fake MC particle representing the trigger information
@@ -128,45 +372,80 @@ public:
 
 private:
     /**
-     *  @brief  Loop over MC trajectory points and identify start and end points within the detector
+     *  @brief  Create links between a single 2D hit and Pandora MC particles
      *
      *  @param  settings the settings
-     *  @param  particle the true particle
-     *  @param  startT the first trajectory point in the detector
-     *  @param  endT the last trajectory point in the detector
+     *  @param  hitID the Pandora hit ID
+     *  @param  begin the first true energy deposit for the hit
+     *  @param  end the end of the true energy deposits for the hit
      */
-    static void GetTrueStartAndEndPoints(const Settings &settings, const art::Ptr<simb::MCParticle> &particle, int &startT, int &endT);
+    static void CreatePandoraMCLinks(const Settings &settings, const int hitID, const TrackIDEVector::const_iterator &begin,
+        const TrackIDEVector::const_iterator &end);
 
     /**
-     *  @brief  Loop over MC trajectory points and identify start and end points within a given cryostat and TPC
+     *  @brief  Loop over MC trajectory points and identify start and end points within the detector
      *
-     *  @param  cstat the cryostat
-     *  @param  tpc the TPC
+     *  @param  tpcGridIndex the grid index of tpc bounding boxes
      *  @param  particle the true particle
      *  @param  startT the first trajectory point in the detector
      *  @param  endT the last trajectory point in the detector
      */
-    static void GetTrueStartAndEndPoints(const unsigned int cstat, const unsigned int tpc, const art::Ptr<simb::MCParticle> &particle,
-        int &startT, int &endT);
+    static void GetTrueStartAndEndPoints(const LArTpcGridIndex &tpcGridIndex, const art::Ptr<simb::MCParticle> &particle, int &startT, int &endT);
 
     /**
      *  @brief  Use detector and time services to get a true X offset for a given trajectory point
      *
+     *  @param  tpcGridIndex the grid index of tpc bounding boxes
      *  @param  particle the true particle
      *  @param  nT the trajectory point
      */
-    static float GetTrueX0(const art::Ptr<simb::MCParticle> &particle, const int nT);
+    static float GetTrueX0(const LArTpcGridIndex &tpcGridIndex, const art::Ptr<simb::MCParticle> &particle, const int nT);
 
     /**
-     *  @brief  Convert charge in ADCs to approximate MIPs
+     *  @brief  Get the key of the momentum cell containing a given momentum
      *
-     *  @param  settings the settings
-     *  @param  hit_Charge the input charge
-     *  @param  hit_View the input view number
+     *  @param  px the x component of the momentum
+     *  @param  py the y component of the momentum
+     *  @param  pz the z component of the momentum
+     */
+    static PrimaryParticleIndex::MomentumKey GetMomentumKey(const double px, const double py, const double pz);
+
+    /**
+     *  @brief  Get the index (u = 0, v = 1, w = 2) of a pandora global view
+     *
+     *  @param  pandora_View the global view
+     */
+    static unsigned int GetViewIndex(const geo::View_t pandora_View);
+
+    /**
+     *  @brief  Project a (y, z) position into a pandora global view, using the transformation plugin
+     *
+     *  @param  pTransform the transformation plugin
+     *  @param  pandora_View the global view
+     *  @param  y the y coordinate
+     *  @param  z the z coordinate
      */
-    static double GetMips(const Settings &settings, const double hit_Charge, const geo::View_t hit_View);
+    static double ProjectYZ(const pandora::LArTransformationPlugin *const pTransform, const geo::View_t pandora_View, const double y, const double z);
 };
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline size_t LArPandoraInput::HitBatch::Size() const
+{
+    return m_hits.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double LArPandoraInput::HitConversionConstants::GetTabulatedMips(const double dQdX) const
+{
+    const double position(std::min(std::max(dQdX * m_birksTableInverseStep, 0.), m_birksTableMaxPosition));
+    const size_t node(static_cast<size_t>(position));
+    const double fraction(position - static_cast<double>(node));
+
+    return m_birksTable[node] + fraction * (m_birksTable[node + 1] - m_birksTable[node]);
+}
+
 } // namespace lar_pandora
 
 #endif // #ifndef LAR_PANDORA_INPUT_H
@@ -0,0 +1,289 @@
+/**
+ *  @file   larpandora/LArPandoraInterface/LArPandoraInstrumentation.cxx
+ *
+ *  @brief  Per-event timing and counting of the stages of the LArPandora producer
+ */
+
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Services/Optional/TFileService.h"
+#include "art/Framework/Services/Registry/ServiceHandle.h"
+#include "cetlib_except/exception.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include "TTree.h"
+
+#include "larpandora/LArPandoraInterface/LArPandoraInstrumentation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace lar_pandora
+{
+
+LArPandoraInstrumentation::LArPandoraInstrumentation(const bool shouldWriteTree, const std::string &jsonFileName, const unsigned int scheduleId) :
+    m_shouldWriteTree(shouldWriteTree),
+    m_treeName(scheduleId ? "timing_schedule" + std::to_string(scheduleId) : "timing"),
+    m_jsonFileName((scheduleId && !jsonFileName.empty()) ? jsonFileName + "." + std::to_string(scheduleId) : jsonFileName),
+    m_pTree(nullptr),
+    m_run(0),
+    m_subRun(0),
+    m_event(0)
+{
+    m_stageTimes.fill(0.);
+    m_counts.fill(0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArPandoraInstrumentation::~LArPandoraInstrumentation()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInstrumentation::BeginJob()
+{
+    if (m_shouldWriteTree)
+    {
+        art::ServiceHandle<art::TFileService> tfs;
+        m_pTree = tfs->make<TTree>(m_treeName.c_str(), "LArPandora per-event timing");
+        m_pTree->Branch("run", &m_run, "run/i");
+        m_pTree->Branch("subRun", &m_subRun, "subRun/i");
+        m_pTree->Branch("event", &m_event, "event/i");
+
+        for (unsigned int stage = 0; stage < kNStages; ++stage)
+        {
+            const std::string name("t" + LArPandoraInstrumentation::GetName(static_cast<Stage>(stage)));
+            m_pTree->Branch(name.c_str(), &m_stageTimes[stage], (name + "/D").c_str());
+        }
+
+        for (unsigned int counter = 0; counter < kNCounters; ++counter)
+        {
+            const std::string name(LArPandoraInstrumentation::GetName(static_cast<Counter>(counter)));
+            m_pTree->Branch(name.c_str(), &m_counts[counter], (name + "/l").c_str());
+        }
+
+        m_pTree->Branch("sliceNHits", &m_sliceNHits);
+        m_pTree->Branch("sliceNNeutrinoPfos", &m_sliceNNeutrinoPfos);
+        m_pTree->Branch("sliceNCosmicPfos", &m_sliceNCosmicPfos);
+    }
+
+    if (!m_jsonFileName.empty())
+    {
+        m_pJsonFile.reset(new std::ofstream(m_jsonFileName));
+
+        if (!m_pJsonFile->good())
+            throw cet::exception("LArPandora") << " LArPandoraInstrumentation::BeginJob --- can't open file " << m_jsonFileName;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInstrumentation::BeginEvent(const art::Event &evt)
+{
+    m_run = evt.run();
+    m_subRun = evt.subRun();
+    m_event = evt.event();
+    m_stageTimes.fill(0.);
+    m_counts.fill(0);
+    m_sliceNHits.clear();
+    m_sliceNNeutrinoPfos.clear();
+    m_sliceNCosmicPfos.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInstrumentation::AddSliceOccupancy(const unsigned int nHits, const unsigned int nNeutrinoOutcomePfos,
+    const unsigned int nCosmicOutcomePfos)
+{
+    m_sliceNHits.push_back(nHits);
+    m_sliceNNeutrinoPfos.push_back(nNeutrinoOutcomePfos);
+    m_sliceNCosmicPfos.push_back(nCosmicOutcomePfos);
+
+    this->AddCount(kNPandoraSlices, 1);
+    this->AddCount(kNNeutrinoOutcomePfos, nNeutrinoOutcomePfos);
+    this->AddCount(kNCosmicOutcomePfos, nCosmicOutcomePfos);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInstrumentation::EndEvent()
+{
+    for (unsigned int stage = 0; stage < kNStages; ++stage)
+        m_stageTimeHistograms[stage].Fill(m_stageTimes[stage]);
+
+    if (m_pTree)
+        m_pTree->Fill();
+
+    if (m_pJsonFile)
+    {
+        std::ofstream &file(*m_pJsonFile);
+        file << "{\"run\":" << m_run << ",\"subRun\":" << m_subRun << ",\"event\":" << m_event << ",\"times\":{";
+
+        for (unsigned int stage = 0; stage < kNStages; ++stage)
+            file << (stage ? "," : "") << "\"" << LArPandoraInstrumentation::GetName(static_cast<Stage>(stage)) << "\":" << m_stageTimes[stage];
+
+        file << "},\"counts\":{";
+
+        for (unsigned int counter = 0; counter < kNCounters; ++counter)
+            file << (counter ? "," : "") << "\"" << LArPandoraInstrumentation::GetName(static_cast<Counter>(counter)) << "\":" << m_counts[counter];
+
+        file << "},\"slices\":[";
+
+        for (unsigned int slice = 0; slice < m_sliceNHits.size(); ++slice)
+        {
+            file << (slice ? "," : "") << "{\"nHits\":" << m_sliceNHits[slice] << ",\"nNeutrinoPfos\":" << m_sliceNNeutrinoPfos[slice]
+                 << ",\"nCosmicPfos\":" << m_sliceNCosmicPfos[slice] << "}";
+        }
+
+        file << "]}\n";
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInstrumentation::Summarise() const
+{
+    if (!m_stageTimeHistograms[kTotal].GetNEntries())
+        return;
+
+    mf::LogInfo logInfo("LArPandora");
+    logInfo << " LArPandoraInstrumentation::Summarise - time per event (ms) over " << m_stageTimeHistograms[kTotal].GetNEntries() << " events: stage, mean, p50, p90, p99, max";
+
+    for (unsigned int stage = 0; stage < kNStages; ++stage)
+    {
+        const TimeHistogram &histogram(m_stageTimeHistograms[stage]);
+
+        logInfo << "\n   " << LArPandoraInstrumentation::GetName(static_cast<Stage>(stage)) << ", " << 1000. * histogram.GetMean() << ", "
+                << 1000. * histogram.GetPercentile(50.) << ", "
+                << 1000. * histogram.GetPercentile(90.) << ", "
+                << 1000. * histogram.GetPercentile(99.) << ", "
+                << 1000. * histogram.GetMaximum();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+std::string LArPandoraInstrumentation::GetName(const Stage stage)
+{
+    switch (stage)
+    {
+        case kInputHitConversion: return "InputHitConversion";
+        case kInputTruthCollection: return "InputTruthCollection";
+        case kInputRegistration: return "InputRegistration";
+        case kRunPandora: return "RunPandora";
+        case kOutputCollection: return "OutputCollection";
+        case kOutputSpacePoints: return "OutputSpacePoints";
+        case kOutputClusters: return "OutputClusters";
+        case kOutputParticles: return "OutputParticles";
+        case kOutputSlices: return "OutputSlices";
+        case kOutputPut: return "OutputPut";
+        case kReset: return "Reset";
+        case kTotal: return "Total";
+        default: break;
+    }
+
+    throw cet::exception("LArPandora") << " LArPandoraInstrumentation::GetName --- unknown stage " << static_cast<int>(stage);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+std::string LArPandoraInstrumentation::GetName(const Counter counter)
+{
+    switch (counter)
+    {
+        case kNInputHits: return "nInputHits";
+        case kNPandoraHits: return "nPandoraHits";
+        case kNOutputPfos: return "nOutputPfos";
+        case kNOutputClusters: return "nOutputClusters";
+        case kNOutputSpacePoints: return "nOutputSpacePoints";
+        case kNOutputSlices: return "nOutputSlices";
+        case kNPoolAllocations: return "nPoolAllocations";
+        case kNPoolChunkAllocations: return "nPoolChunkAllocations";
+        case kNPandoraSlices: return "nPandoraSlices";
+        case kNNeutrinoOutcomePfos: return "nNeutrinoOutcomePfos";
+        case kNCosmicOutcomePfos: return "nCosmicOutcomePfos";
+        default: break;
+    }
+
+    throw cet::exception("LArPandora") << " LArPandoraInstrumentation::GetName --- unknown counter " << static_cast<int>(counter);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArPandoraInstrumentation::TimeHistogram::TimeHistogram() :
+    m_nEntries(0),
+    m_sum(0.),
+    m_maximum(0.)
+{
+    m_binCounts.fill(0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraInstrumentation::TimeHistogram::Fill(const double seconds)
+{
+    const double nBinsAboveMinimum((seconds > 0.) ? m_nBinsPerDecade * (std::log10(seconds) + 6.) : -1.);
+    const unsigned int bin((nBinsAboveMinimum < 0.) ? 0 : (nBinsAboveMinimum >= m_nBins - 2) ? m_nBins - 1 :
+        1 + static_cast<unsigned int>(nBinsAboveMinimum));
+
+    ++m_binCounts.at(bin);
+    ++m_nEntries;
+    m_sum += seconds;
+    m_maximum = std::max(m_maximum, seconds);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+unsigned long long LArPandoraInstrumentation::TimeHistogram::GetNEntries() const
+{
+    return m_nEntries;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+double LArPandoraInstrumentation::TimeHistogram::GetMean() const
+{
+    return m_nEntries ? m_sum / m_nEntries : 0.;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+double LArPandoraInstrumentation::TimeHistogram::GetMaximum() const
+{
+    return m_maximum;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+double LArPandoraInstrumentation::TimeHistogram::GetPercentile(const double percentile) const
+{
+    if (!m_nEntries)
+        return 0.;
+
+    const unsigned long long rank(std::max(1ULL, static_cast<unsigned long long>(std::ceil(percentile / 100. * m_nEntries))));
+    unsigned long long nBelow(0);
+
+    for (unsigned int bin = 0; bin < m_nBins; ++bin)
+    {
+        nBelow += m_binCounts[bin];
+
+        if (nBelow >= rank)
+            return std::min(this->GetUpperEdge(bin), m_maximum);
+    }
+
+    return m_maximum;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+double LArPandoraInstrumentation::TimeHistogram::GetUpperEdge(const unsigned int bin) const
+{
+    // ATTN The overflow bin has no upper edge, so is capped by the maximum
+    if (bin + 1 >= m_nBins)
+        return m_maximum;
+
+    return std::pow(10., static_cast<double>(bin) / m_nBinsPerDecade - 6.);
+}
+
+} // namespace lar_pandora
@@ -0,0 +1,309 @@
+/**
+ *  @file   larpandora/LArPandoraInterface/LArPandoraInstrumentation.h
+ *
+ *  @brief  Per-event timing and counting of the stages of the LArPandora producer
+ */
+
+#ifndef LAR_PANDORA_INSTRUMENTATION_H
+#define LAR_PANDORA_INSTRUMENTATION_H 1
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace art {class Event;}
+class TTree;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lar_pandora
+{
+
+/**
+ *  @brief  LArPandoraInstrumentation class, recording the time spent in each stage of an event, the numbers of objects in and out and,
+ *          optionally, the slice occupancy: the numbers of hits and outcome particles of each pandora slice. It does not time the pandora
+ *          algorithms or tools themselves. The records of each event may be written to a TFileService tree and/or a
+ *          JSON-lines file, and are summarised at the end of the job
+ */
+class LArPandoraInstrumentation
+{
+public:
+    /**
+     *  @brief  Stage enumeration
+     */
+    enum Stage
+    {
+        kInputHitConversion = 0,    // Filling, converting and filtering the hit batch
+        kInputTruthCollection,      // Collecting the mc information and building the hit to mc particle links
+        kInputRegistration,         // Registering the hits and mc information with the pandora instance
+        kRunPandora,                // Running the pandora instances
+        kOutputCollection,          // Collecting the pandora objects and resolving their hits
+        kOutputSpacePoints,         // Building the space points
+        kOutputClusters,            // Building the clusters
+        kOutputParticles,           // Building the particles and their metadata
+        kOutputSlices,              // Building the slices
+        kOutputPut,                 // Putting the products into the event
+        kReset,                     // Resetting the pandora instances
+        kTotal,                     // The whole event
+        kNStages
+    };
+
+    /**
+     *  @brief  Counter enumeration
+     */
+    enum Counter
+    {
+        kNInputHits = 0,            // The ART hits read
+        kNPandoraHits,              // The hits passed to pandora
+        kNOutputPfos,               // The particles produced
+        kNOutputClusters,           // The clusters produced
+        kNOutputSpacePoints,        // The 3D hits output
+        kNOutputSlices,             // The slices produced
+        kNPoolAllocations,          // The calo hits and mc particles whose storage was taken from the pools
+        kNPoolChunkAllocations,     // The chunks of pool storage newly allocated on the heap
+        kNPandoraSlices,            // The slices found by the pandora slicing instance
+        kNNeutrinoOutcomePfos,      // The particles of the neutrino reconstruction of the slices
+        kNCosmicOutcomePfos,        // The particles of the cosmic-ray reconstruction of the slices
+        kNCounters
+    };
+
+    /**
+     *  @brief  ScopedTimer class, adding the time between its construction and its destruction, or an earlier call to Stop, to a stage
+     */
+    class ScopedTimer
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  pInstrumentation the address of the instrumentation, may be nullptr in which case nothing is timed
+         *  @param  stage the stage to time
+         */
+        ScopedTimer(LArPandoraInstrumentation *const pInstrumentation, const Stage stage);
+
+        /**
+         *  @brief  Destructor
+         */
+        ~ScopedTimer();
+
+        /**
+         *  @brief  Stop the timer, adding the elapsed time to the stage
+         */
+        void Stop();
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        LArPandoraInstrumentation  *m_pInstrumentation;        ///< The address of the instrumentation, nullptr once stopped
+        const Stage                 m_stage;                    ///< The stage being timed
+        const Clock::time_point     m_start;                    ///< The start time
+    };
+
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  shouldWriteTree whether to write the per-event records to a TFileService tree. The TFileService is a legacy service, which
+     *          art allows only in jobs with a single schedule
+     *  @param  jsonFileName the name of the JSON-lines file for the per-event records, empty for no file
+     *  @param  scheduleId the id of the art schedule of the producer replica; outputs of schedules other than the first are suffixed by the id
+     */
+    LArPandoraInstrumentation(const bool shouldWriteTree, const std::string &jsonFileName, const unsigned int scheduleId = 0);
+
+    /**
+     *  @brief  Destructor
+     */
+    ~LArPandoraInstrumentation();
+
+    /**
+     *  @brief  Book the outputs, at the start of the job
+     */
+    void BeginJob();
+
+    /**
+     *  @brief  Clear the record, at the start of an event
+     *
+     *  @param  evt the ART event
+     */
+    void BeginEvent(const art::Event &evt);
+
+    /**
+     *  @brief  Add time to a stage of the current event. Concurrent calls are safe only for different stages
+     *
+     *  @param  stage the stage
+     *  @param  seconds the time to add (s)
+     */
+    void AddTime(const Stage stage, const double seconds);
+
+    /**
+     *  @brief  Add to a counter of the current event
+     *
+     *  @param  counter the counter
+     *  @param  count the number to add
+     */
+    void AddCount(const Counter counter, const size_t count);
+
+    /**
+     *  @brief  Add the occupancy of a slice found by the pandora instances to the current event, adding to the slice and outcome counters
+     *
+     *  @param  nHits the number of hits in the slice
+     *  @param  nNeutrinoOutcomePfos the number of particles of the neutrino reconstruction of the slice
+     *  @param  nCosmicOutcomePfos the number of particles of the cosmic-ray reconstruction of the slice
+     */
+    void AddSliceOccupancy(const unsigned int nHits, const unsigned int nNeutrinoOutcomePfos, const unsigned int nCosmicOutcomePfos);
+
+    /**
+     *  @brief  Write the record of the current event, and add its times to the histograms for the summary
+     */
+    void EndEvent();
+
+    /**
+     *  @brief  Log the mean, maximum and approximate percentiles of the time spent in each stage, at the end of the job
+     */
+    void Summarise() const;
+
+    /**
+     *  @brief  Get the name of a stage
+     *
+     *  @param  stage the stage
+     */
+    static std::string GetName(const Stage stage);
+
+    /**
+     *  @brief  Get the name of a counter
+     *
+     *  @param  counter the counter
+     */
+    static std::string GetName(const Counter counter);
+
+private:
+    typedef std::array<double, kNStages> StageTimes;
+    typedef std::array<unsigned long long, kNCounters> Counts;
+    typedef std::vector<unsigned int> SliceCounts;
+
+    /**
+     *  @brief  TimeHistogram class, a fixed-size histogram of times with logarithmic bins, keeping the exact number of entries, sum and
+     *          maximum, from which the percentiles are estimated without storing the time of every event
+     */
+    class TimeHistogram
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        TimeHistogram();
+
+        /**
+         *  @brief  Add a time to the histogram
+         *
+         *  @param  seconds the time (s)
+         */
+        void Fill(const double seconds);
+
+        /**
+         *  @brief  Get the number of times added
+         */
+        unsigned long long GetNEntries() const;
+
+        /**
+         *  @brief  Get the mean of the times added (s)
+         */
+        double GetMean() const;
+
+        /**
+         *  @brief  Get the maximum of the times added (s)
+         */
+        double GetMaximum() const;
+
+        /**
+         *  @brief  Get a percentile of the times added, using the nearest rank and returning the upper edge of its bin, capped at the maximum (s)
+         *
+         *  @param  percentile the percentile
+         */
+        double GetPercentile(const double percentile) const;
+
+    private:
+        static const unsigned int m_nBinsPerDecade = 20;   ///< The number of bins per decade, giving a bin width of about 12%
+        static const unsigned int m_nDecades = 10;         ///< The number of decades, from 1 microsecond to 10000 seconds
+        static const unsigned int m_nBins = m_nBinsPerDecade * m_nDecades + 2; ///< The number of bins, including under- and overflow
+
+        /**
+         *  @brief  Get the upper edge of a bin (s)
+         *
+         *  @param  bin the bin
+         */
+        double GetUpperEdge(const unsigned int bin) const;
+
+        std::array<unsigned long long, m_nBins> m_binCounts;   ///< The number of times in each bin
+        unsigned long long                      m_nEntries;     ///< The number of times added
+        double                                  m_sum;          ///< The sum of the times added (s)
+        double                                  m_maximum;      ///< The maximum of the times added (s)
+    };
+
+    const bool                      m_shouldWriteTree;      ///< Whether to write the per-event records to a TFileService tree
+    const std::string               m_treeName;             ///< The name of the tree of per-event records
+    const std::string               m_jsonFileName;         ///< The name of the JSON-lines file, empty for no file
+    TTree                          *m_pTree;                ///< The tree of per-event records, owned by the TFileService
+    std::unique_ptr<std::ofstream>  m_pJsonFile;            ///< The JSON-lines file of per-event records
+
+    unsigned int                    m_run;                  ///< The run number of the current event
+    unsigned int                    m_subRun;               ///< The subrun number of the current event
+    unsigned int                    m_event;                ///< The event number of the current event
+    StageTimes                      m_stageTimes;           ///< The time spent in each stage of the current event (s)
+    Counts                          m_counts;               ///< The counters of the current event
+    SliceCounts                     m_sliceNHits;           ///< The number of hits in each slice of the current event
+    SliceCounts                     m_sliceNNeutrinoPfos;   ///< The number of neutrino outcome particles of each slice of the current event
+    SliceCounts                     m_sliceNCosmicPfos;     ///< The number of cosmic-ray outcome particles of each slice of the current event
+
+    std::array<TimeHistogram, kNStages> m_stageTimeHistograms; ///< The histograms of the time spent in each stage of the events
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArPandoraInstrumentation::ScopedTimer::ScopedTimer(LArPandoraInstrumentation *const pInstrumentation, const Stage stage) :
+    m_pInstrumentation(pInstrumentation),
+    m_stage(stage),
+    m_start(pInstrumentation ? Clock::now() : Clock::time_point())
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArPandoraInstrumentation::ScopedTimer::~ScopedTimer()
+{
+    this->Stop();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArPandoraInstrumentation::ScopedTimer::Stop()
+{
+    if (!m_pInstrumentation)
+        return;
+
+    m_pInstrumentation->AddTime(m_stage, std::chrono::duration<double>(Clock::now() - m_start).count());
+    m_pInstrumentation = nullptr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArPandoraInstrumentation::AddTime(const Stage stage, const double seconds)
+{
+    m_stageTimes.at(stage) += seconds;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArPandoraInstrumentation::AddCount(const Counter counter, const size_t count)
+{
+    m_counts.at(counter) += count;
+}
+
+} // namespace lar_pandora
+
+#endif // #ifndef LAR_PANDORA_INSTRUMENTATION_H
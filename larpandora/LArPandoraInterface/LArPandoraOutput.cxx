@@ -5,7 +5,7 @@
  *
  */
 
-#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/Modifier.h"
 #include "cetlib_except/exception.h"
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
@@ -39,7 +39,13 @@
 
 #include "larpandora/LArPandoraInterface/LArPandoraOutput.h"
 
+#include "tbb/parallel_for.h"
+
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
 #include <iterator>
 #include <iostream>
 #include <limits>
@@ -52,6 +58,90 @@ void LArPandoraOutput::ProduceArtOutput(const Settings &settings, const IdToHitM
     settings.Validate();
     const std::string instanceLabel(settings.m_shouldProduceAllOutcomes ? settings.m_allOutcomesInstanceLabel : "");
 
+    // Collect immutable lists of pandora collections that we should convert to ART format
+    const pandora::PfoVector pfoVector(settings.m_shouldProduceAllOutcomes ?
+        LArPandoraOutput::CollectAllPfoOutcomes(settings.m_pPrimaryPandora) :
+        LArPandoraOutput::CollectPfos(settings.m_pPrimaryPandora));
+
+    // ATTN A single output instance can never reuse its own clusters, so no cluster cache is needed
+    CaloHitResolutionTable caloHitResolutionTable(idToHitMap, idToHitMap.size());
+    LArPandoraOutput::ProduceArtOutput(settings, instanceLabel, pfoVector, caloHitResolutionTable, nullptr, evt);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraOutput::ProduceCombinedArtOutput(const Settings &settings, const IdToHitMap &idToHitMap, art::Event &evt)
+{
+    Settings allOutcomesSettings(settings);
+    allOutcomesSettings.m_shouldProduceAllOutcomes = true;
+    allOutcomesSettings.Validate();
+
+    // ATTN The consolidated outcome is (a copy of) a subset of all outcomes, so its hits and clusters are found in the shared tables
+    CaloHitResolutionTable caloHitResolutionTable(idToHitMap, idToHitMap.size());
+    ClusterCache clusterCache;
+
+    const pandora::PfoVector allOutcomesPfoVector(LArPandoraOutput::CollectAllPfoOutcomes(settings.m_pPrimaryPandora));
+    LArPandoraOutput::ProduceArtOutput(allOutcomesSettings, allOutcomesSettings.m_allOutcomesInstanceLabel, allOutcomesPfoVector,
+        caloHitResolutionTable, &clusterCache, evt);
+
+    const pandora::PfoVector pfoVector(LArPandoraOutput::CollectPfos(settings.m_pPrimaryPandora));
+    LArPandoraOutput::ProduceArtOutput(settings, "", pfoVector, caloHitResolutionTable, &clusterCache, evt);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraOutput::ProduceEmptyArtOutput(const Settings &settings, const std::string &instanceLabel, art::Event &evt)
+{
+    evt.put(PFParticleCollection(new std::vector<recob::PFParticle>), instanceLabel);
+
+    if (settings.m_shouldProduceSpacePoints)
+    {
+        evt.put(SpacePointCollection(new std::vector<recob::SpacePoint>), instanceLabel);
+        evt.put(PFParticleToSpacePointCollection(new art::Assns<recob::PFParticle, recob::SpacePoint>), instanceLabel);
+        evt.put(SpacePointToHitCollection(new art::Assns<recob::SpacePoint, recob::Hit>), instanceLabel);
+    }
+
+    if (settings.m_shouldProduceCompactSpacePoints)
+        evt.put(CompactSpacePointsCollection(new larpandoraobj::CompactSpacePoints(settings.m_compactSpacePointResolution)), instanceLabel);
+
+    if (settings.m_shouldProduceClusters)
+    {
+        evt.put(ClusterCollection(new std::vector<recob::Cluster>), instanceLabel);
+        evt.put(PFParticleToClusterCollection(new art::Assns<recob::PFParticle, recob::Cluster>), instanceLabel);
+        evt.put(ClusterToHitCollection(new art::Assns<recob::Cluster, recob::Hit>), instanceLabel);
+    }
+
+    if (settings.m_shouldProduceVertices)
+    {
+        evt.put(VertexCollection(new std::vector<recob::Vertex>), instanceLabel);
+        evt.put(PFParticleToVertexCollection(new art::Assns<recob::PFParticle, recob::Vertex>), instanceLabel);
+    }
+
+    if (settings.m_shouldProduceMetadata)
+    {
+        evt.put(PFParticleMetadataCollection(new std::vector<larpandoraobj::PFParticleMetadata>), instanceLabel);
+        evt.put(PFParticleToMetadataCollection(new art::Assns<recob::PFParticle, larpandoraobj::PFParticleMetadata>), instanceLabel);
+    }
+
+    if (settings.m_shouldProduceSlices)
+    {
+        evt.put(SliceCollection(new std::vector<recob::Slice>), instanceLabel);
+        evt.put(PFParticleToSliceCollection(new art::Assns<recob::PFParticle, recob::Slice>), instanceLabel);
+        evt.put(SliceToHitCollection(new art::Assns<recob::Slice, recob::Hit>), instanceLabel);
+    }
+
+    if (settings.m_shouldRunStitching)
+    {
+        evt.put(T0Collection(new std::vector<anab::T0>), instanceLabel);
+        evt.put(PFParticleToT0Collection(new art::Assns<recob::PFParticle, anab::T0>), instanceLabel);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraOutput::ProduceArtOutput(const Settings &settings, const std::string &instanceLabel, const pandora::PfoVector &pfoVector,
+    CaloHitResolutionTable &caloHitResolutionTable, ClusterCache *const pClusterCache, art::Event &evt)
+{
     // Set up the output collections
     PFParticleCollection            outputParticles( new std::vector<recob::PFParticle> );
     VertexCollection                outputVertices( new std::vector<recob::Vertex> );
@@ -60,6 +150,8 @@ void LArPandoraOutput::ProduceArtOutput(const Settings &settings, const IdToHitM
     T0Collection                    outputT0s( new std::vector<anab::T0> );
     PFParticleMetadataCollection    outputParticleMetadata( new std::vector<larpandoraobj::PFParticleMetadata> );
     SliceCollection                 outputSlices( new std::vector<recob::Slice> );
+    CompactSpacePointsCollection    outputCompactSpacePoints( settings.m_shouldProduceCompactSpacePoints ?
+                                        new larpandoraobj::CompactSpacePoints(settings.m_compactSpacePointResolution) : nullptr );
 
     // Set up the output associations
     PFParticleToMetadataCollection    outputParticlesToMetadata( new art::Assns<recob::PFParticle, larpandoraobj::PFParticleMetadata> );
@@ -72,55 +164,123 @@ void LArPandoraOutput::ProduceArtOutput(const Settings &settings, const IdToHitM
     SpacePointToHitCollection         outputSpacePointsToHits( new art::Assns<recob::SpacePoint, recob::Hit> );
     SliceToHitCollection              outputSlicesToHits( new art::Assns<recob::Slice, recob::Hit> );
 
-    // Collect immutable lists of pandora collections that we should convert to ART format
-    const pandora::PfoVector pfoVector(settings.m_shouldProduceAllOutcomes ?
-        LArPandoraOutput::CollectAllPfoOutcomes(settings.m_pPrimaryPandora) :
-        LArPandoraOutput::CollectPfos(settings.m_pPrimaryPandora));
+    // Collect immutable lists of pandora collections that we should convert to ART format, skipping those for disabled products
+    LArPandoraInstrumentation *const pInstrumentation(settings.m_pInstrumentation);
+    LArPandoraInstrumentation::ScopedTimer collectionTimer(pInstrumentation, LArPandoraInstrumentation::kOutputCollection);
 
     IdToIdVectorMap pfoToVerticesMap;
-    const pandora::VertexVector vertexVector(LArPandoraOutput::CollectVertices(pfoVector, pfoToVerticesMap));
+    const pandora::VertexVector vertexVector(settings.m_shouldProduceVertices ?
+        LArPandoraOutput::CollectVertices(pfoVector, pfoToVerticesMap) : pandora::VertexVector());
+
+    // Index the pfos and clusters once, so that all subsequent id lookups are constant time
+    PfoToIdMap pfoToIdMap;
+    LArPandoraOutput::GetIdMap(pfoVector, pfoToIdMap);
 
     IdToIdVectorMap pfoToClustersMap;
-    const pandora::ClusterList clusterList(LArPandoraOutput::CollectClusters(pfoVector, pfoToClustersMap));
+    const pandora::ClusterList clusterList(settings.m_shouldProduceClusters ?
+        LArPandoraOutput::CollectClusters(pfoVector, pfoToClustersMap) : pandora::ClusterList());
+
+    ClusterToIdMap clusterToIdMap;
+    LArPandoraOutput::GetIdMap(clusterList, clusterToIdMap);
 
     IdToIdVectorMap pfoToThreeDHitsMap;
-    const pandora::CaloHitList threeDHitList(LArPandoraOutput::Collect3DHits(pfoVector, pfoToThreeDHitsMap));
+    const pandora::CaloHitList threeDHitList((settings.m_shouldProduceSpacePoints || settings.m_shouldProduceCompactSpacePoints) ?
+        LArPandoraOutput::Collect3DHits(pfoVector, pfoToThreeDHitsMap) : pandora::CaloHitList());
 
     // Get mapping from pandora hits to art hits
     CaloHitToArtHitMap pandoraHitToArtHitMap;
-    LArPandoraOutput::GetPandoraToArtHitMap(clusterList, threeDHitList, idToHitMap, pandoraHitToArtHitMap);
+    LArPandoraOutput::GetPandoraToArtHitMap(clusterList, settings.m_shouldProduceSpacePoints ? threeDHitList : pandora::CaloHitList(),
+        caloHitResolutionTable, pandoraHitToArtHitMap);
+
+    if (settings.m_shouldProduceVertices)
+        LArPandoraOutput::BuildVertices(vertexVector, outputVertices);
+
+    collectionTimer.Stop();
 
     // Build the ART outputs from the pandora objects
-    LArPandoraOutput::BuildVertices(vertexVector, outputVertices);
-    LArPandoraOutput::BuildSpacePoints(evt, settings.m_pProducer, instanceLabel, threeDHitList, pandoraHitToArtHitMap, outputSpacePoints, outputSpacePointsToHits);
+    LArPandoraInstrumentation::ScopedTimer spacePointTimer(pInstrumentation, LArPandoraInstrumentation::kOutputSpacePoints);
+
+    if (settings.m_shouldProduceSpacePoints)
+        LArPandoraOutput::BuildSpacePoints(evt, settings.m_pProducer, instanceLabel, threeDHitList, pandoraHitToArtHitMap, outputSpacePoints, outputSpacePointsToHits);
+
+    if (settings.m_shouldProduceCompactSpacePoints)
+        LArPandoraOutput::BuildCompactSpacePoints(pfoVector.size(), threeDHitList, pfoToThreeDHitsMap, outputCompactSpacePoints);
+
+    spacePointTimer.Stop();
 
     IdToIdVectorMap pfoToArtClustersMap;
-    LArPandoraOutput::BuildClusters(evt, settings.m_pProducer, instanceLabel, clusterList, pandoraHitToArtHitMap, pfoToClustersMap, outputClusters, outputClustersToHits, pfoToArtClustersMap);
+    if (settings.m_shouldProduceClusters)
+    {
+        LArPandoraInstrumentation::ScopedTimer clusterTimer(pInstrumentation, LArPandoraInstrumentation::kOutputClusters);
+        LArPandoraOutput::BuildClusters(evt, settings.m_pProducer, instanceLabel, clusterList, clusterToIdMap, pandoraHitToArtHitMap, pfoToClustersMap, pClusterCache, settings.m_shouldBuildClustersInParallel,
+            settings.m_clusterParameterLevel, outputClusters, outputClustersToHits, pfoToArtClustersMap);
+    }
 
-    LArPandoraOutput::BuildPFParticles(evt, settings.m_pProducer, instanceLabel, pfoVector, pfoToVerticesMap, pfoToThreeDHitsMap, pfoToArtClustersMap, outputParticles, outputParticlesToVertices, outputParticlesToSpacePoints, outputParticlesToClusters);
+    LArPandoraInstrumentation::ScopedTimer particleTimer(pInstrumentation, LArPandoraInstrumentation::kOutputParticles);
+    LArPandoraOutput::BuildPFParticles(evt, settings.m_pProducer, instanceLabel, pfoVector, pfoToIdMap, pfoToVerticesMap,
+        settings.m_shouldProduceSpacePoints ? pfoToThreeDHitsMap : IdToIdVectorMap(), pfoToArtClustersMap, outputParticles, outputParticlesToVertices, outputParticlesToSpacePoints, outputParticlesToClusters);
 
-    LArPandoraOutput::BuildParticleMetadata(evt, settings.m_pProducer, instanceLabel, pfoVector, outputParticleMetadata, outputParticlesToMetadata);
-    LArPandoraOutput::BuildSlices(settings, settings.m_pPrimaryPandora, evt, settings.m_pProducer, instanceLabel, pfoVector, idToHitMap, outputSlices, outputParticlesToSlices, outputSlicesToHits);
+    if (settings.m_shouldProduceMetadata)
+        LArPandoraOutput::BuildParticleMetadata(evt, settings.m_pProducer, instanceLabel, pfoVector, outputParticleMetadata, outputParticlesToMetadata);
 
     if (settings.m_shouldRunStitching)
         LArPandoraOutput::BuildT0s(evt, settings.m_pProducer, instanceLabel, pfoVector, outputT0s, outputParticlesToT0s);
 
+    particleTimer.Stop();
+
+    if (settings.m_shouldProduceSlices)
+    {
+        LArPandoraInstrumentation::ScopedTimer sliceTimer(pInstrumentation, LArPandoraInstrumentation::kOutputSlices);
+        LArPandoraOutput::BuildSlices(settings, settings.m_pPrimaryPandora, evt, settings.m_pProducer, instanceLabel, pfoVector, caloHitResolutionTable, outputSlices, outputParticlesToSlices, outputSlicesToHits);
+    }
+
+    if (pInstrumentation)
+    {
+        pInstrumentation->AddCount(LArPandoraInstrumentation::kNOutputPfos, outputParticles->size());
+        pInstrumentation->AddCount(LArPandoraInstrumentation::kNOutputClusters, outputClusters->size());
+        pInstrumentation->AddCount(LArPandoraInstrumentation::kNOutputSpacePoints, threeDHitList.size());
+        pInstrumentation->AddCount(LArPandoraInstrumentation::kNOutputSlices, outputSlices->size());
+    }
+
     // Add the outputs to the event
+    LArPandoraInstrumentation::ScopedTimer putTimer(pInstrumentation, LArPandoraInstrumentation::kOutputPut);
     evt.put(std::move(outputParticles), instanceLabel);
-    evt.put(std::move(outputSpacePoints), instanceLabel);
-    evt.put(std::move(outputClusters), instanceLabel);
-    evt.put(std::move(outputVertices), instanceLabel);
-    evt.put(std::move(outputParticleMetadata), instanceLabel);
-    evt.put(std::move(outputSlices), instanceLabel);
-
-    evt.put(std::move(outputParticlesToMetadata), instanceLabel);
-    evt.put(std::move(outputParticlesToSpacePoints), instanceLabel);
-    evt.put(std::move(outputParticlesToClusters), instanceLabel);
-    evt.put(std::move(outputParticlesToVertices), instanceLabel);
-    evt.put(std::move(outputParticlesToSlices), instanceLabel);
-    evt.put(std::move(outputSpacePointsToHits), instanceLabel);
-    evt.put(std::move(outputClustersToHits), instanceLabel);
-    evt.put(std::move(outputSlicesToHits), instanceLabel);
+
+    if (settings.m_shouldProduceSpacePoints)
+    {
+        evt.put(std::move(outputSpacePoints), instanceLabel);
+        evt.put(std::move(outputParticlesToSpacePoints), instanceLabel);
+        evt.put(std::move(outputSpacePointsToHits), instanceLabel);
+    }
+
+    if (settings.m_shouldProduceCompactSpacePoints)
+        evt.put(std::move(outputCompactSpacePoints), instanceLabel);
+
+    if (settings.m_shouldProduceClusters)
+    {
+        evt.put(std::move(outputClusters), instanceLabel);
+        evt.put(std::move(outputParticlesToClusters), instanceLabel);
+        evt.put(std::move(outputClustersToHits), instanceLabel);
+    }
+
+    if (settings.m_shouldProduceVertices)
+    {
+        evt.put(std::move(outputVertices), instanceLabel);
+        evt.put(std::move(outputParticlesToVertices), instanceLabel);
+    }
+
+    if (settings.m_shouldProduceMetadata)
+    {
+        evt.put(std::move(outputParticleMetadata), instanceLabel);
+        evt.put(std::move(outputParticlesToMetadata), instanceLabel);
+    }
+
+    if (settings.m_shouldProduceSlices)
+    {
+        evt.put(std::move(outputSlices), instanceLabel);
+        evt.put(std::move(outputParticlesToSlices), instanceLabel);
+        evt.put(std::move(outputSlicesToHits), instanceLabel);
+    }
 
     if (settings.m_shouldRunStitching)
     {
@@ -294,6 +454,7 @@ void LArPandoraOutput::CollectPfos(const pandora::PfoList &parentPfoList, pandor
 pandora::VertexVector LArPandoraOutput::CollectVertices(const pandora::PfoVector &pfoVector, IdToIdVectorMap &pfoToVerticesMap)
 {
     pandora::VertexVector vertexVector;
+    VertexToIdMap vertexToIdMap;
 
     for (unsigned int pfoId = 0; pfoId < pfoVector.size(); ++pfoId)
     {
@@ -305,11 +466,10 @@ pandora::VertexVector LArPandoraOutput::CollectVertices(const pandora::PfoVector
         const pandora::Vertex *const pVertex(lar_content::LArPfoHelper::GetVertex(pPfo));
 
         // Get the vertex ID and add it to the vertex list if required
-        const auto it(std::find(vertexVector.begin(), vertexVector.end(), pVertex));
-        const bool isInList(it != vertexVector.end());
-        const size_t vertexId(isInList ? std::distance(vertexVector.begin(), it) : vertexVector.size());
-        
-        if (!isInList)
+        const auto insertResult(vertexToIdMap.emplace(pVertex, vertexVector.size()));
+        const size_t vertexId(insertResult.first->second);
+
+        if (insertResult.second)
             vertexVector.push_back(pVertex);
 
         if (!pfoToVerticesMap.insert(IdToIdVectorMap::value_type(pfoId, {vertexId})).second)
@@ -391,7 +551,7 @@ void LArPandoraOutput::Collect3DHits(const pandora::ParticleFlowObject *const pP
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 void LArPandoraOutput::GetPandoraToArtHitMap(const pandora::ClusterList &clusterList, const pandora::CaloHitList &threeDHitList, 
-    const IdToHitMap &idToHitMap, CaloHitToArtHitMap &pandoraHitToArtHitMap)
+    CaloHitResolutionTable &caloHitResolutionTable, CaloHitToArtHitMap &pandoraHitToArtHitMap)
 {
     // Collect 2D hits from clusters
     for (const pandora::Cluster *const pCluster : clusterList)
@@ -404,7 +564,7 @@ void LArPandoraOutput::GetPandoraToArtHitMap(const pandora::ClusterList &cluster
 
         for (const pandora::CaloHit *const pCaloHit : sortedHits)
         {
-            if (!pandoraHitToArtHitMap.insert(CaloHitToArtHitMap::value_type(pCaloHit, LArPandoraOutput::GetHit(idToHitMap, pCaloHit))).second)
+            if (!pandoraHitToArtHitMap.insert(CaloHitToArtHitMap::value_type(pCaloHit, caloHitResolutionTable.GetHit(pCaloHit))).second)
                 throw cet::exception("LArPandora") << " LArPandoraOutput::GetPandoraToArtHitMap --- found repeated input hits ";
         }
     }
@@ -415,45 +575,13 @@ void LArPandoraOutput::GetPandoraToArtHitMap(const pandora::ClusterList &cluster
             throw cet::exception("LArPandora") << " LArPandoraOutput::GetPandoraToArtHitMap --- found a non-3D hit in the input list ";
 
         // ATTN get the 2D calo hit from the 3D calo hit then find the art hit!
-        if (!pandoraHitToArtHitMap.insert(CaloHitToArtHitMap::value_type(pCaloHit, LArPandoraOutput::GetHit(idToHitMap, static_cast<const pandora::CaloHit*>(pCaloHit->GetParentAddress())))).second)
+        if (!pandoraHitToArtHitMap.insert(CaloHitToArtHitMap::value_type(pCaloHit, caloHitResolutionTable.GetHit(static_cast<const pandora::CaloHit*>(pCaloHit->GetParentAddress())))).second)
             throw cet::exception("LArPandora") << " LArPandoraOutput::GetPandoraToArtHitMap --- found repeated input hits ";
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-art::Ptr<recob::Hit> LArPandoraOutput::GetHit(const IdToHitMap &idToHitMap, const pandora::CaloHit *const pCaloHit)
-{
-    //  TODO make this less evil
-
-    // ATTN The CaloHit can come from the primary pandora instance (depth = 0) or one of its daughers (depth = 1).
-    //      Here we keep trying to access the ART hit increasing the depth step-by-step
-    for (unsigned int depth = 0, maxDepth = 2; depth < maxDepth; ++depth)
-    {
-        // Navigate to the hit address in the pandora master instance (assuming the depth is correct)
-        const pandora::CaloHit *pParentCaloHit = pCaloHit;
-        for (unsigned int i = 0; i < depth; ++i)
-            pParentCaloHit = static_cast<const pandora::CaloHit *>(pCaloHit->GetParentAddress());
-
-        // Attempt to find the mapping from the "parent" calo hit to the ART hit
-        const void *const pHitAddress(pParentCaloHit->GetParentAddress());
-        const intptr_t hitID_temp((intptr_t)(pHitAddress));
-        const int hitID((int)(hitID_temp));
-    
-        IdToHitMap::const_iterator artIter = idToHitMap.find(hitID);
-    
-        // If there is no such mapping from "parent" calo hit to the ART hit, then increase the depth and try again!
-        if (idToHitMap.end() == artIter)
-            continue;
-
-        return artIter->second;
-    }
-     
-    throw cet::exception("LArPandora") << " LArPandoraOutput::GetHit --- found a Pandora hit without a parent ART hit ";
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-
 void LArPandoraOutput::BuildVertices(const pandora::VertexVector &vertexVector, VertexCollection &outputVertices)
 {
     for (size_t vertexId = 0; vertexId < vertexVector.size(); ++vertexId)
@@ -462,10 +590,13 @@ void LArPandoraOutput::BuildVertices(const pandora::VertexVector &vertexVector,
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandoraOutput::BuildSpacePoints(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel, 
+void LArPandoraOutput::BuildSpacePoints(const art::Event &event, const art::Modifier *const, const std::string &instanceLabel, 
     const pandora::CaloHitList &threeDHitList, const CaloHitToArtHitMap &pandoraHitToArtHitMap, SpacePointCollection &outputSpacePoints,
     SpacePointToHitCollection &outputSpacePointsToHits)
 {
+    AssociationBuilder<recob::SpacePoint, recob::Hit> spacePointToHitBuilder(event, instanceLabel, outputSpacePointsToHits);
+    outputSpacePoints->reserve(outputSpacePoints->size() + threeDHitList.size());
+
     pandora::CaloHitVector threeDHitVector;
     threeDHitVector.insert(threeDHitVector.end(), threeDHitList.begin(), threeDHitList.end());
 
@@ -477,37 +608,118 @@ void LArPandoraOutput::BuildSpacePoints(const art::Event &event, const art::EDPr
         if (it == pandoraHitToArtHitMap.end())
             throw cet::exception("LArPandora") << " LArPandoraOutput::BuildSpacePoints --- found a pandora hit without a corresponding art hit ";
 
-        LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, hitId, {it->second}, outputSpacePointsToHits);
+        spacePointToHitBuilder.Add(hitId, it->second);
         outputSpacePoints->push_back(LArPandoraOutput::BuildSpacePoint(pCaloHit, hitId));
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandoraOutput::BuildClusters(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel, const pandora::ClusterList &clusterList,
-    const CaloHitToArtHitMap &pandoraHitToArtHitMap, const IdToIdVectorMap &pfoToClustersMap, ClusterCollection &outputClusters, 
-    ClusterToHitCollection &outputClustersToHits, IdToIdVectorMap &pfoToArtClustersMap)
+void LArPandoraOutput::BuildCompactSpacePoints(const size_t nPfos, const pandora::CaloHitList &threeDHitList, const IdToIdVectorMap &pfoToThreeDHitsMap,
+    CompactSpacePointsCollection &outputCompactSpacePoints)
 {
+    const pandora::CaloHitVector threeDHitVector(threeDHitList.begin(), threeDHitList.end());
+
+    for (size_t pfoId = 0; pfoId < nPfos; ++pfoId)
+    {
+        IdToIdVectorMap::const_iterator it(pfoToThreeDHitsMap.find(pfoId));
+
+        if (it != pfoToThreeDHitsMap.end())
+        {
+            for (const size_t hitId : it->second)
+            {
+                const pandora::CartesianVector &position(threeDHitVector.at(hitId)->GetPositionVector());
+                outputCompactSpacePoints->AddPoint(position.GetX(), position.GetY(), position.GetZ());
+            }
+        }
+
+        outputCompactSpacePoints->CloseParticle();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraOutput::BuildClusters(const art::Event &event, const art::Modifier *const, const std::string &instanceLabel, const pandora::ClusterList &clusterList,
+    const ClusterToIdMap &clusterToIdMap, const CaloHitToArtHitMap &pandoraHitToArtHitMap, const IdToIdVectorMap &pfoToClustersMap, ClusterCache *const pClusterCache,
+    const bool shouldBuildInParallel, const ClusterParameterLevel clusterParameterLevel, ClusterCollection &outputClusters, ClusterToHitCollection &outputClustersToHits,
+    IdToIdVectorMap &pfoToArtClustersMap)
+{
+    // Collect the hits for each art cluster, and identify the clusters whose parameters have yet to be calculated
+    std::vector< std::vector<ClusterHits> > clusterHitsVectors;
+    clusterHitsVectors.reserve(clusterList.size());
+
+    std::vector<const ClusterHits*> uncachedClusterHits;
+
+    for (const pandora::Cluster *const pCluster : clusterList)
+    {
+        clusterHitsVectors.push_back(std::vector<ClusterHits>());
+        LArPandoraOutput::GetClusterHits(pCluster, pandoraHitToArtHitMap, clusterHitsVectors.back());
+
+        for (const ClusterHits &clusterHits : clusterHitsVectors.back())
+        {
+            if (!pClusterCache || !pClusterCache->Find(clusterHits))
+                uncachedClusterHits.push_back(&clusterHits);
+        }
+    }
+
+    // Calculate the cluster parameters; the clusters are independent, so may be built concurrently if the parameter algorithm isn't used
+    std::vector<recob::Cluster> uncachedClusters(uncachedClusterHits.size());
     cluster::StandardClusterParamsAlg clusterParamAlgo;
-    
-    // Produce the art clusters
+
+    auto buildCluster = [&uncachedClusterHits, &uncachedClusters, clusterParameterLevel](const size_t index, cluster::ClusterParamsAlgBase &algo)
+    {
+        const ClusterHits &clusterHits(*uncachedClusterHits.at(index));
+        const HitList isolatedHits(clusterHits.second.begin(), clusterHits.second.end());
+        uncachedClusters.at(index) = LArPandoraOutput::BuildCluster(index, clusterHits.first, isolatedHits, algo, clusterParameterLevel);
+    };
+
+    // ATTN The parameter algorithm uses art services and ROOT (TPrincipal), neither of which may be used from worker threads, so clusters
+    // are only built concurrently at the levels that read nothing but the hits. The unused algorithm is constructed on the module thread
+    if (shouldBuildInParallel && (kClusterFull != clusterParameterLevel))
+    {
+        tbb::parallel_for(size_t(0), uncachedClusterHits.size(), [&buildCluster, &clusterParamAlgo](const size_t index)
+        {
+            buildCluster(index, clusterParamAlgo);
+        });
+    }
+    else
+    {
+        for (size_t index = 0; index < uncachedClusterHits.size(); ++index)
+            buildCluster(index, clusterParamAlgo);
+    }
+
+    // Produce the art clusters, assigning ids and associations in the order of the input clusters
+    AssociationBuilder<recob::Cluster, recob::Hit> clusterToHitBuilder(event, instanceLabel, outputClustersToHits);
     size_t nextClusterId(0);
     IdToIdVectorMap pandoraClusterToArtClustersMap;
-    for (const pandora::Cluster *const pCluster : clusterList)
-    {
-        std::vector<HitVector> hitVectors;
-        const std::vector<recob::Cluster> clusters(LArPandoraOutput::BuildClusters(pCluster, clusterList, pandoraHitToArtHitMap, pandoraClusterToArtClustersMap, hitVectors, nextClusterId, clusterParamAlgo));
+    pandora::ClusterList::const_iterator clusterIter(clusterList.begin());
+    size_t uncachedIndex(0);
 
-        if (hitVectors.size() != clusters.size())
-            throw cet::exception("LArPandora") << " LArPandoraOutput::BuildClusters --- invalid hit vectors for clusters produced ";
+    for (const std::vector<ClusterHits> &clusterHitsVector : clusterHitsVectors)
+    {
+        const size_t clusterId(LArPandoraOutput::GetId(*(clusterIter++), clusterToIdMap));
+        if (!pandoraClusterToArtClustersMap.insert(IdToIdVectorMap::value_type(clusterId, {})).second)
+            throw cet::exception("LArPandora") << " LArPandoraOutput::BuildClusters --- repeated clusters in input list ";
 
-        for (unsigned int i = 0; i < clusters.size(); ++i)
+        for (const ClusterHits &clusterHits : clusterHitsVector)
         {
-            LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, nextClusterId - 1, hitVectors.at(i), outputClustersToHits);
-            outputClusters->push_back(clusters.at(i));
+            // ATTN The uncached clusters were collected in this same order
+            const bool isUncached((uncachedIndex < uncachedClusterHits.size()) && (&clusterHits == uncachedClusterHits.at(uncachedIndex)));
+            const recob::Cluster &cluster(isUncached ? uncachedClusters.at(uncachedIndex++) : *pClusterCache->Find(clusterHits));
+
+            clusterToHitBuilder.Add(nextClusterId, clusterHits.first);
+            outputClusters->push_back(LArPandoraOutput::CopyCluster(cluster, nextClusterId));
+            pandoraClusterToArtClustersMap.at(clusterId).push_back(nextClusterId);
+            ++nextClusterId;
         }
     }
 
+    if (pClusterCache)
+    {
+        for (size_t index = 0; index < uncachedClusterHits.size(); ++index)
+            pClusterCache->Add(*uncachedClusterHits.at(index), uncachedClusters.at(index));
+    }
+
     // Get mapping from pfo id to art cluster id
     for (IdToIdVectorMap::const_iterator it = pfoToClustersMap.begin(); it != pfoToClustersMap.end(); ++it)
     {
@@ -529,40 +741,51 @@ void LArPandoraOutput::BuildClusters(const art::Event &event, const art::EDProdu
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandoraOutput::BuildPFParticles(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel, const pandora::PfoVector &pfoVector, 
-    const IdToIdVectorMap &pfoToVerticesMap, const IdToIdVectorMap &pfoToThreeDHitsMap, const IdToIdVectorMap &pfoToArtClustersMap,
+void LArPandoraOutput::BuildPFParticles(const art::Event &event, const art::Modifier *const, const std::string &instanceLabel, const pandora::PfoVector &pfoVector, 
+    const PfoToIdMap &pfoToIdMap, const IdToIdVectorMap &pfoToVerticesMap, const IdToIdVectorMap &pfoToThreeDHitsMap, const IdToIdVectorMap &pfoToArtClustersMap,
     PFParticleCollection &outputParticles, PFParticleToVertexCollection &outputParticlesToVertices, 
     PFParticleToSpacePointCollection &outputParticlesToSpacePoints, PFParticleToClusterCollection &outputParticlesToClusters)
 {
+    AssociationBuilder<recob::PFParticle, recob::Vertex> particleToVertexBuilder(event, instanceLabel, outputParticlesToVertices);
+    AssociationBuilder<recob::PFParticle, recob::SpacePoint> particleToSpacePointBuilder(event, instanceLabel, outputParticlesToSpacePoints);
+    AssociationBuilder<recob::PFParticle, recob::Cluster> particleToClusterBuilder(event, instanceLabel, outputParticlesToClusters);
+    outputParticles->reserve(outputParticles->size() + pfoVector.size());
+
     for (unsigned int pfoId = 0; pfoId < pfoVector.size(); ++pfoId)
     {
         const pandora::ParticleFlowObject *const pPfo(pfoVector.at(pfoId));
 
-        outputParticles->push_back(LArPandoraOutput::BuildPFParticle(pPfo, pfoId, pfoVector));
+        outputParticles->push_back(LArPandoraOutput::BuildPFParticle(pPfo, pfoId, pfoToIdMap));
        
         // Associations from PFParticle
-        if (pfoToVerticesMap.find(pfoId) != pfoToVerticesMap.end())
-            LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, pfoId, pfoToVerticesMap, outputParticlesToVertices);
+        IdToIdVectorMap::const_iterator verticesIter(pfoToVerticesMap.find(pfoId));
+        if (verticesIter != pfoToVerticesMap.end())
+            particleToVertexBuilder.Add(pfoId, verticesIter->second);
 
-        if (pfoToThreeDHitsMap.find(pfoId) != pfoToThreeDHitsMap.end())
-            LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, pfoId, pfoToThreeDHitsMap, outputParticlesToSpacePoints);
+        IdToIdVectorMap::const_iterator threeDHitsIter(pfoToThreeDHitsMap.find(pfoId));
+        if (threeDHitsIter != pfoToThreeDHitsMap.end())
+            particleToSpacePointBuilder.Add(pfoId, threeDHitsIter->second);
 
-        if (pfoToArtClustersMap.find(pfoId) != pfoToArtClustersMap.end())
-            LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, pfoId, pfoToArtClustersMap, outputParticlesToClusters);
+        IdToIdVectorMap::const_iterator artClustersIter(pfoToArtClustersMap.find(pfoId));
+        if (artClustersIter != pfoToArtClustersMap.end())
+            particleToClusterBuilder.Add(pfoId, artClustersIter->second);
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandoraOutput::BuildParticleMetadata(const art::Event &event, const art::EDProducer *const pProducer,
+void LArPandoraOutput::BuildParticleMetadata(const art::Event &event, const art::Modifier *const,
     const std::string &instanceLabel, const pandora::PfoVector &pfoVector, PFParticleMetadataCollection &outputParticleMetadata,
     PFParticleToMetadataCollection &outputParticlesToMetadata) 
 {
+    AssociationBuilder<recob::PFParticle, larpandoraobj::PFParticleMetadata> particleToMetadataBuilder(event, instanceLabel, outputParticlesToMetadata);
+    outputParticleMetadata->reserve(outputParticleMetadata->size() + pfoVector.size());
+
     for (unsigned int pfoId = 0; pfoId < pfoVector.size(); ++pfoId)
     {
         const pandora::ParticleFlowObject *const pPfo(pfoVector.at(pfoId));
         
-        LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, pfoId, outputParticleMetadata->size(), outputParticlesToMetadata);
+        particleToMetadataBuilder.Add(pfoId, outputParticleMetadata->size());
         larpandoraobj::PFParticleMetadata pPFParticleMetadata(LArPandoraHelper::GetPFParticleMetadata(pPfo));
 		outputParticleMetadata->push_back(pPFParticleMetadata);
     }
@@ -571,14 +794,17 @@ void LArPandoraOutput::BuildParticleMetadata(const art::Event &event, const art:
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 void LArPandoraOutput::BuildSlices(const Settings &settings, const pandora::Pandora *const pPrimaryPandora, const art::Event &event,
-    const art::EDProducer *const pProducer, const std::string &instanceLabel, const pandora::PfoVector &pfoVector, 
-    const IdToHitMap &idToHitMap, SliceCollection &outputSlices, PFParticleToSliceCollection &outputParticlesToSlices,
+    const art::Modifier *const, const std::string &instanceLabel, const pandora::PfoVector &pfoVector, 
+    CaloHitResolutionTable &caloHitResolutionTable, SliceCollection &outputSlices, PFParticleToSliceCollection &outputParticlesToSlices,
     SliceToHitCollection &outputSlicesToHits)
 {
+    PFParticleToSliceBuilder particleToSliceBuilder(event, instanceLabel, outputParticlesToSlices);
+    SliceToHitBuilder sliceToHitBuilder(event, instanceLabel, outputSlicesToHits);
+
     // Check for the special case in which there are no slices, and only the neutrino reconstruction was used on all hits
     if (settings.m_isNeutrinoRecoOnlyNoSlicing)
     {
-        LArPandoraOutput::CopyAllHitsToSingleSlice(settings, event, pProducer, instanceLabel, pfoVector, idToHitMap, outputSlices, outputParticlesToSlices, outputSlicesToHits);
+        LArPandoraOutput::CopyAllHitsToSingleSlice(settings, event, pfoVector, outputSlices, particleToSliceBuilder, sliceToHitBuilder);
         return;
     }
     
@@ -588,7 +814,7 @@ void LArPandoraOutput::BuildSlices(const Settings &settings, const pandora::Pand
 
     // Make one slice per Pandora Slice pfo
     for (const pandora::ParticleFlowObject *const pSlicePfo : slicePfos)
-        LArPandoraOutput::BuildSlice(pSlicePfo, event, pProducer, instanceLabel, idToHitMap, outputSlices, outputSlicesToHits);
+        LArPandoraOutput::BuildSlice(pSlicePfo, caloHitResolutionTable, outputSlices, sliceToHitBuilder);
 
     // Make a slice for every remaining pfo hierarchy that wasn't already in a slice
     std::unordered_map<const pandora::ParticleFlowObject *, unsigned int> parentPfoToSliceIndexMap;
@@ -603,7 +829,7 @@ void LArPandoraOutput::BuildSlices(const Settings &settings, const pandora::Pand
         if (lar_content::LArPfoHelper::GetParentPfo(pPfo) != pPfo)
             continue;
 
-        if (!parentPfoToSliceIndexMap.emplace(pPfo, LArPandoraOutput::BuildSlice(pPfo, event, pProducer, instanceLabel, idToHitMap, outputSlices, outputSlicesToHits)).second)
+        if (!parentPfoToSliceIndexMap.emplace(pPfo, LArPandoraOutput::BuildSlice(pPfo, caloHitResolutionTable, outputSlices, sliceToHitBuilder)).second)
             throw cet::exception("LArPandora") << " LArPandoraOutput::BuildSlices --- found repeated primary particles ";
     }
 
@@ -615,7 +841,7 @@ void LArPandoraOutput::BuildSlices(const Settings &settings, const pandora::Pand
         // For PFOs that are from a Pandora slice, add the association and move on to the next PFO
         if (LArPandoraOutput::IsFromSlice(pPfo))
         {
-            LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, pfoId, LArPandoraOutput::GetSliceIndex(pPfo), outputParticlesToSlices);
+            particleToSliceBuilder.Add(pfoId, LArPandoraOutput::GetSliceIndex(pPfo));
             continue;
         }
        
@@ -625,7 +851,7 @@ void LArPandoraOutput::BuildSlices(const Settings &settings, const pandora::Pand
             throw cet::exception("LArPandora") << " LArPandoraOutput::BuildSlices --- found pfo without a parent in the input list ";
 
         // Add the association from the PFO to the slice
-        LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, pfoId, parentPfoToSliceIndexMap.at(pParent), outputParticlesToSlices);
+        particleToSliceBuilder.Add(pfoId, parentPfoToSliceIndexMap.at(pParent));
     }
 }
 
@@ -646,33 +872,31 @@ unsigned int LArPandoraOutput::BuildDummySlice(SliceCollection &outputSlices)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandoraOutput::CopyAllHitsToSingleSlice(const Settings &settings, const art::Event &event, const art::EDProducer *const pProducer,
-    const std::string &instanceLabel, const pandora::PfoVector &pfoVector, const IdToHitMap &idToHitMap, SliceCollection &outputSlices,
-    PFParticleToSliceCollection &outputParticlesToSlices, SliceToHitCollection &outputSlicesToHits)
+void LArPandoraOutput::CopyAllHitsToSingleSlice(const Settings &settings, const art::Event &event, const pandora::PfoVector &pfoVector,
+    SliceCollection &outputSlices, PFParticleToSliceBuilder &particleToSliceBuilder, SliceToHitBuilder &sliceToHitBuilder)
 {
     const unsigned int sliceIndex(LArPandoraOutput::BuildDummySlice(outputSlices));
 
     // Add all of the hits in the events to the slice
     HitVector hits;
     LArPandoraHelper::CollectHits(event, settings.m_hitfinderModuleLabel, hits);
-    LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, sliceIndex, hits, outputSlicesToHits);
+    sliceToHitBuilder.Add(sliceIndex, hits);
 
     mf::LogDebug("LArPandora") << "Finding hits with label: " << settings.m_hitfinderModuleLabel << std::endl;
     mf::LogDebug("LArPandora") << " - Found " << hits.size() << std::endl;
-    mf::LogDebug("LArPandora") << " - Making associations " << outputSlicesToHits->size() << std::endl;
+    mf::LogDebug("LArPandora") << " - Making associations " << hits.size() << std::endl;
 
     // Add all of the PFOs to the slice
     for (unsigned int pfoId = 0; pfoId < pfoVector.size(); ++pfoId)
-        LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, pfoId, sliceIndex, outputParticlesToSlices);
+        particleToSliceBuilder.Add(pfoId, sliceIndex);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-unsigned int LArPandoraOutput::BuildSlice(const pandora::ParticleFlowObject *const pParentPfo, const art::Event &event,
-    const art::EDProducer *const pProducer, const std::string &instanceLabel, const IdToHitMap &idToHitMap, SliceCollection &outputSlices,
-    SliceToHitCollection &outputSlicesToHits)
+unsigned int LArPandoraOutput::BuildSlice(const pandora::ParticleFlowObject *const pParentPfo, CaloHitResolutionTable &caloHitResolutionTable,
+    SliceCollection &outputSlices, SliceToHitBuilder &sliceToHitBuilder)
 {
-    const unsigned int sliceIndex(LArPandoraOutput::BuildDummySlice(outputSlices));
+    const unsigned int sliceIndex(outputSlices->size());
 
     // Collect the pfos connected to the input primary pfos
     pandora::PfoList pfosInSlice;
@@ -680,7 +904,7 @@ unsigned int LArPandoraOutput::BuildSlice(const pandora::ParticleFlowObject *con
     pfosInSlice.sort(lar_content::LArPfoHelper::SortByNHits);
 
     // Collect the hits from the pfos in all views
-    pandora::CaloHitList hits;
+    pandora::CaloHitList hits, threeDHits;
     for (const pandora::ParticleFlowObject *const pPfo : pfosInSlice)
     {
         for (const pandora::HitType &hitType : {pandora::TPC_VIEW_U, pandora::TPC_VIEW_V, pandora::TPC_VIEW_W})
@@ -688,48 +912,215 @@ unsigned int LArPandoraOutput::BuildSlice(const pandora::ParticleFlowObject *con
             lar_content::LArPfoHelper::GetCaloHits(pPfo, hitType, hits);
             lar_content::LArPfoHelper::GetIsolatedCaloHits(pPfo, hitType, hits);
         }
+
+        lar_content::LArPfoHelper::GetCaloHits(pPfo, pandora::TPC_3D, threeDHits);
     }
 
-    // Add the associations to the hits
+    // Add the associations to the hits, as a single block
+    HitVector sliceHits;
+    sliceHits.reserve(hits.size());
+
     for (const pandora::CaloHit *const pCaloHit : hits)
-        LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, sliceIndex, {LArPandoraOutput::GetHit(idToHitMap, pCaloHit)}, outputSlicesToHits);
+        sliceHits.push_back(caloHitResolutionTable.GetHit(pCaloHit));
+
+    sliceToHitBuilder.Add(sliceIndex, sliceHits);
+    outputSlices->push_back(LArPandoraOutput::BuildSliceSummary(sliceIndex, threeDHits, sliceHits));
 
     return sliceIndex;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArPandoraOutput::BuildT0s(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel, const pandora::PfoVector &pfoVector, 
+recob::Slice LArPandoraOutput::BuildSliceSummary(const unsigned int sliceIndex, const pandora::CaloHitList &threeDHitList, const HitVector &sliceHits)
+{
+    const float bogusFloat(std::numeric_limits<float>::max());
+    recob::tracking::Point_t center(bogusFloat, bogusFloat, bogusFloat), end0(center), end1(center);
+    recob::tracking::Vector_t direction(bogusFloat, bogusFloat, bogusFloat);
+    float aspectRatio(bogusFloat);
+
+    double charge(0.);
+    for (const art::Ptr<recob::Hit> &hit : sliceHits)
+        charge += hit->Integral();
+
+    if (threeDHitList.empty())
+        return recob::Slice(sliceIndex, center, direction, end0, end1, aspectRatio, static_cast<float>(charge));
+
+    // Charge-weighted centroid, falling back to equal weights if the 3D hits carry no charge
+    double totalWeight(0.);
+    for (const pandora::CaloHit *const pCaloHit : threeDHitList)
+        totalWeight += std::max(0.f, pCaloHit->GetInputEnergy());
+
+    const bool useEqualWeights(totalWeight <= std::numeric_limits<double>::epsilon());
+    if (useEqualWeights)
+        totalWeight = static_cast<double>(threeDHitList.size());
+
+    Vector3 centroid{{0., 0., 0.}};
+    for (const pandora::CaloHit *const pCaloHit : threeDHitList)
+    {
+        const double weight(useEqualWeights ? 1. : std::max(0.f, pCaloHit->GetInputEnergy()));
+        const pandora::CartesianVector &position(pCaloHit->GetPositionVector());
+        centroid[0] += weight * position.GetX();
+        centroid[1] += weight * position.GetY();
+        centroid[2] += weight * position.GetZ();
+    }
+
+    for (double &coordinate : centroid)
+        coordinate /= totalWeight;
+
+    center = recob::tracking::Point_t(centroid[0], centroid[1], centroid[2]);
+
+    // Principal axis from the charge-weighted covariance matrix
+    Matrix3 covariance{{{{0., 0., 0.}}, {{0., 0., 0.}}, {{0., 0., 0.}}}};
+    for (const pandora::CaloHit *const pCaloHit : threeDHitList)
+    {
+        const double weight(useEqualWeights ? 1. : std::max(0.f, pCaloHit->GetInputEnergy()));
+        const pandora::CartesianVector &position(pCaloHit->GetPositionVector());
+        const Vector3 displacement{{position.GetX() - centroid[0], position.GetY() - centroid[1], position.GetZ() - centroid[2]}};
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            for (unsigned int j = i; j < 3; ++j)
+                covariance[i][j] += weight * displacement[i] * displacement[j];
+        }
+    }
+
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        for (unsigned int j = i; j < 3; ++j)
+        {
+            covariance[i][j] /= totalWeight;
+            covariance[j][i] = covariance[i][j];
+        }
+    }
+
+    Vector3 eigenValues;
+    Matrix3 eigenVectors;
+    LArPandoraOutput::DiagonaliseSymmetricMatrix(covariance, eigenValues, eigenVectors);
+
+    std::array<unsigned int, 3> order{{0, 1, 2}};
+    std::sort(order.begin(), order.end(), [&eigenValues](const unsigned int lhs, const unsigned int rhs) {return (eigenValues[lhs] > eigenValues[rhs]);});
+
+    const double principalEigenValue(eigenValues[order[0]]);
+    if (principalEigenValue <= std::numeric_limits<double>::epsilon())
+        return recob::Slice(sliceIndex, center, direction, end0, end1, aspectRatio, static_cast<float>(charge));
+
+    const Vector3 axis{{eigenVectors[0][order[0]], eigenVectors[1][order[0]], eigenVectors[2][order[0]]}};
+    direction = recob::tracking::Vector_t(axis[0], axis[1], axis[2]);
+    aspectRatio = static_cast<float>(std::sqrt(std::max(0., eigenValues[order[1]]) / principalEigenValue));
+
+    // End points are the hits with the smallest and largest projections onto the principal axis
+    double minProjection(std::numeric_limits<double>::max()), maxProjection(-std::numeric_limits<double>::max());
+    for (const pandora::CaloHit *const pCaloHit : threeDHitList)
+    {
+        const pandora::CartesianVector &position(pCaloHit->GetPositionVector());
+        const double projection((position.GetX() - centroid[0]) * axis[0] + (position.GetY() - centroid[1]) * axis[1] + (position.GetZ() - centroid[2]) * axis[2]);
+
+        if (projection < minProjection)
+        {
+            minProjection = projection;
+            end0 = recob::tracking::Point_t(position.GetX(), position.GetY(), position.GetZ());
+        }
+
+        if (projection > maxProjection)
+        {
+            maxProjection = projection;
+            end1 = recob::tracking::Point_t(position.GetX(), position.GetY(), position.GetZ());
+        }
+    }
+
+    return recob::Slice(sliceIndex, center, direction, end0, end1, aspectRatio, static_cast<float>(charge));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraOutput::DiagonaliseSymmetricMatrix(Matrix3 &matrix, Vector3 &eigenValues, Matrix3 &eigenVectors)
+{
+    eigenVectors = {{{{1., 0., 0.}}, {{0., 1., 0.}}, {{0., 0., 1.}}}};
+
+    const unsigned int maxSweeps(50);
+    for (unsigned int sweep = 0; sweep < maxSweeps; ++sweep)
+    {
+        const double offDiagonal(std::fabs(matrix[0][1]) + std::fabs(matrix[0][2]) + std::fabs(matrix[1][2]));
+        const double diagonal(std::fabs(matrix[0][0]) + std::fabs(matrix[1][1]) + std::fabs(matrix[2][2]));
+
+        if (offDiagonal <= std::numeric_limits<double>::epsilon() * diagonal || offDiagonal < std::numeric_limits<double>::min())
+            break;
+
+        for (unsigned int p = 0; p < 2; ++p)
+        {
+            for (unsigned int q = p + 1; q < 3; ++q)
+            {
+                if (std::fabs(matrix[p][q]) < std::numeric_limits<double>::min())
+                    continue;
+
+                // Rotation zeroing element (p, q)
+                const double theta((matrix[q][q] - matrix[p][p]) / (2. * matrix[p][q]));
+                const double t(((theta < 0.) ? -1. : 1.) / (std::fabs(theta) + std::sqrt(theta * theta + 1.)));
+                const double c(1. / std::sqrt(t * t + 1.)), s(t * c);
+
+                for (unsigned int k = 0; k < 3; ++k)
+                {
+                    const double kp(matrix[k][p]), kq(matrix[k][q]);
+                    matrix[k][p] = c * kp - s * kq;
+                    matrix[k][q] = s * kp + c * kq;
+                }
+
+                for (unsigned int k = 0; k < 3; ++k)
+                {
+                    const double pk(matrix[p][k]), qk(matrix[q][k]);
+                    matrix[p][k] = c * pk - s * qk;
+                    matrix[q][k] = s * pk + c * qk;
+                }
+
+                for (unsigned int k = 0; k < 3; ++k)
+                {
+                    const double kp(eigenVectors[k][p]), kq(eigenVectors[k][q]);
+                    eigenVectors[k][p] = c * kp - s * kq;
+                    eigenVectors[k][q] = s * kp + c * kq;
+                }
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < 3; ++i)
+        eigenValues[i] = matrix[i][i];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPandoraOutput::BuildT0s(const art::Event &event, const art::Modifier *const, const std::string &instanceLabel, const pandora::PfoVector &pfoVector, 
     T0Collection &outputT0s, PFParticleToT0Collection &outputParticlesToT0s)
 {
+    AssociationBuilder<recob::PFParticle, anab::T0> particleToT0Builder(event, instanceLabel, outputParticlesToT0s);
+
     size_t nextT0Id(0);
     for (unsigned int pfoId = 0; pfoId < pfoVector.size(); ++pfoId)
     {
         const pandora::ParticleFlowObject *const pPfo(pfoVector.at(pfoId));
 
         anab::T0 t0;
-        if (!LArPandoraOutput::BuildT0(pPfo, pfoVector, nextT0Id, t0)) continue;
+        if (!LArPandoraOutput::BuildT0(pPfo, pfoId, nextT0Id, t0)) continue;
 
-        LArPandoraOutput::AddAssociation(event, pProducer, instanceLabel, pfoId, nextT0Id - 1, outputParticlesToT0s);
+        particleToT0Builder.Add(pfoId, nextT0Id - 1);
         outputT0s->push_back(t0);
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-recob::PFParticle LArPandoraOutput::BuildPFParticle(const pandora::ParticleFlowObject *const pPfo, const size_t pfoId, const pandora::PfoVector &pfoVector)
+recob::PFParticle LArPandoraOutput::BuildPFParticle(const pandora::ParticleFlowObject *const pPfo, const size_t pfoId, const PfoToIdMap &pfoToIdMap)
 {
     // Get parent Pfo ID
     const pandora::PfoList &parentList(pPfo->GetParentPfoList());
     if (parentList.size() > 1)
         throw cet::exception("LArPandora") << " LArPandoraOutput::BuildPFParticle --- this pfo has multiple parent particles ";
 
-    const size_t parentId(parentList.empty() ? recob::PFParticle::kPFParticlePrimary : LArPandoraOutput::GetId(parentList.front(), pfoVector));
+    const size_t parentId(parentList.empty() ? recob::PFParticle::kPFParticlePrimary : LArPandoraOutput::GetId(parentList.front(), pfoToIdMap));
 
     // Get daughters Pfo IDs
     std::vector<size_t> daughterIds;
     for (const pandora::ParticleFlowObject *const pDaughterPfo : pPfo->GetDaughterPfoList())
-        daughterIds.push_back(LArPandoraOutput::GetId(pDaughterPfo, pfoVector));
+        daughterIds.push_back(LArPandoraOutput::GetId(pDaughterPfo, pfoToIdMap));
 
     std::sort(daughterIds.begin(), daughterIds.end());
 
@@ -761,17 +1152,9 @@ void LArPandoraOutput::GetHitsInCluster(const pandora::Cluster *const pCluster,
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-std::vector<recob::Cluster> LArPandoraOutput::BuildClusters(const pandora::Cluster *const pCluster, const pandora::ClusterList &clusterList,
-    const CaloHitToArtHitMap &pandoraHitToArtHitMap, IdToIdVectorMap &pandoraClusterToArtClustersMap, 
-    std::vector<HitVector> &hitVectors, size_t &nextId, cluster::ClusterParamsAlgBase &algo)
+void LArPandoraOutput::GetClusterHits(const pandora::Cluster *const pCluster, const CaloHitToArtHitMap &pandoraHitToArtHitMap,
+    std::vector<ClusterHits> &clusterHitsVector)
 {
-    std::vector<recob::Cluster> clusters;
-
-    // Get the cluster ID and set up the map entry
-    const size_t clusterId(LArPandoraOutput::GetId(pCluster, clusterList));
-    if (!pandoraClusterToArtClustersMap.insert(IdToIdVectorMap::value_type(clusterId, {})).second)
-        throw cet::exception("LArPandora") << " LArPandoraOutput::BuildClusters --- repeated clusters in input list ";
-
     pandora::CaloHitVector sortedHits;
     LArPandoraOutput::GetHitsInCluster(pCluster, sortedHits);
 
@@ -783,7 +1166,8 @@ std::vector<recob::Cluster> LArPandoraOutput::BuildClusters(const pandora::Clust
         CaloHitToArtHitMap::const_iterator it(pandoraHitToArtHitMap.find(pCaloHit2D));
         if (it == pandoraHitToArtHitMap.end())
             throw cet::exception("LArPandora") << " LArPandoraOutput::BuildClusters --- couldn't find art hit for input pandora hit ";
-            
+
+        // ATTN Dereferencing the hit here also means that the copies stored below need no further product lookup
         const art::Ptr<recob::Hit> hit(it->second);
 
         const geo::WireID wireID(hit->WireID());
@@ -801,19 +1185,21 @@ std::vector<recob::Cluster> LArPandoraOutput::BuildClusters(const pandora::Clust
     {
         const HitVector &clusterHits(hitArrayEntry.second);
 
-        clusters.push_back(LArPandoraOutput::BuildCluster(nextId, clusterHits, isolatedHits, algo));
-        hitVectors.push_back(clusterHits);
-        pandoraClusterToArtClustersMap.at(clusterId).push_back(nextId);
+        HitVector isolatedClusterHits;
+        for (const art::Ptr<recob::Hit> &hit : clusterHits)
+        {
+            if (isolatedHits.count(hit))
+                isolatedClusterHits.push_back(hit);
+        }
 
-        nextId++;
+        clusterHitsVector.push_back(ClusterHits(clusterHits, isolatedClusterHits));
     }
-
-    return clusters;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-recob::Cluster LArPandoraOutput::BuildCluster(const size_t id, const HitVector &hitVector, const HitList &isolatedHits, cluster::ClusterParamsAlgBase &algo)
+recob::Cluster LArPandoraOutput::BuildCluster(const size_t id, const HitVector &hitVector, const HitList &isolatedHits, cluster::ClusterParamsAlgBase &algo,
+    const ClusterParameterLevel clusterParameterLevel)
 {
     if (hitVector.empty())
         throw cet::exception("LArPandora") << " LArPandoraOutput::BuildCluster --- No input hits were provided ";
@@ -827,8 +1213,12 @@ recob::Cluster LArPandoraOutput::BuildCluster(const size_t id, const HitVector &
     double endWire(-std::numeric_limits<float>::max()), sigmaEndWire(0.0);
     double endTime(-std::numeric_limits<float>::max()), sigmaEndTime(0.0);
 
+    const bool useAlgorithm(kClusterFull == clusterParameterLevel);
+    const bool useCharge(kClusterCharge == clusterParameterLevel);
+    double integral(0.0), integralSquared(0.0), summedADC(0.0), summedADCSquared(0.0);
+
     std::vector<recob::Hit const*> hits_for_params;
-    hits_for_params.reserve(hitVector.size());
+    hits_for_params.reserve(useAlgorithm ? hitVector.size() : 0);
 
     for (const art::Ptr<recob::Hit> &hit : hitVector)
     {
@@ -850,7 +1240,17 @@ recob::Cluster LArPandoraOutput::BuildCluster(const size_t id, const HitVector &
             throw cet::exception("LArPandora") << " LArPandoraOutput::BuildCluster --- Input hits have inconsistent plane IDs ";
         }
 
-        hits_for_params.push_back(&*hit);
+        if (useAlgorithm)
+        {
+            hits_for_params.push_back(&*hit);
+        }
+        else if (useCharge)
+        {
+            integral += hit->Integral();
+            integralSquared += hit->Integral() * hit->Integral();
+            summedADC += hit->SummedADC();
+            summedADCSquared += hit->SummedADC() * hit->SummedADC();
+        }
 
         if (isolatedHits.count(hit))
             continue;
@@ -873,6 +1273,21 @@ recob::Cluster LArPandoraOutput::BuildCluster(const size_t id, const HitVector &
 
     }
 
+    if (!useAlgorithm)
+    {
+        // ATTN Inexpensive levels do not run the parameter algorithm: charges, angles, densities and widths are not calculated
+        const double nHits(static_cast<double>(hitVector.size()));
+        const double integralStdDev((nHits > 1.) ? std::sqrt(std::max(0., (integralSquared - integral * integral / nHits) / (nHits - 1.))) : 0.);
+        const double summedADCStdDev((nHits > 1.) ? std::sqrt(std::max(0., (summedADCSquared - summedADC * summedADC / nHits) / (nHits - 1.))) : 0.);
+
+        return recob::Cluster(
+          startWire, sigmaStartWire, startTime, sigmaStartTime, 0.f, 0.f, 0.f,
+          endWire, sigmaEndWire, endTime, sigmaEndTime, 0.f, 0.f, 0.f,
+          integral, integralStdDev, summedADC, summedADCStdDev,
+          hitVector.size(), 0.f, 0.f,
+          id, view, planeID, recob::Cluster::Sentry);
+    }
+
     // feed the algorithm with all the cluster hits
     algo.SetHits(hits_for_params);
 
@@ -896,6 +1311,39 @@ recob::Cluster LArPandoraOutput::BuildCluster(const size_t id, const HitVector &
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+LArPandoraOutput::ClusterParameterLevel LArPandoraOutput::GetClusterParameterLevel(const std::string &name)
+{
+    if ("Positions" == name)
+        return kClusterPositions;
+
+    if ("Charge" == name)
+        return kClusterCharge;
+
+    if ("Full" == name)
+        return kClusterFull;
+
+    throw cet::exception("LArPandora") << " LArPandoraOutput::GetClusterParameterLevel --- unknown cluster parameter level " << name;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+recob::Cluster LArPandoraOutput::CopyCluster(const recob::Cluster &cluster, const size_t id)
+{
+    if (cluster.ID() == static_cast<recob::Cluster::ID_t>(id))
+        return cluster;
+
+    return recob::Cluster(
+      cluster.StartWire(), cluster.SigmaStartWire(), cluster.StartTick(), cluster.SigmaStartTick(),
+      cluster.StartCharge(), cluster.StartAngle(), cluster.StartOpeningAngle(),
+      cluster.EndWire(), cluster.SigmaEndWire(), cluster.EndTick(), cluster.SigmaEndTick(),
+      cluster.EndCharge(), cluster.EndAngle(), cluster.EndOpeningAngle(),
+      cluster.Integral(), cluster.IntegralStdDev(), cluster.SummedADC(), cluster.SummedADCstdDev(),
+      cluster.NHits(), cluster.MultipleHitDensity(), cluster.Width(),
+      id, cluster.View(), cluster.Plane(), recob::Cluster::Sentry);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 recob::SpacePoint LArPandoraOutput::BuildSpacePoint(const pandora::CaloHit *const pCaloHit, const size_t spacePointId)
 {
     if (pandora::TPC_3D != pCaloHit->GetHitType())
@@ -913,7 +1361,7 @@ recob::SpacePoint LArPandoraOutput::BuildSpacePoint(const pandora::CaloHit *cons
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-bool LArPandoraOutput::BuildT0(const pandora::ParticleFlowObject *const pPfo, const pandora::PfoVector &pfoVector, size_t &nextId,
+bool LArPandoraOutput::BuildT0(const pandora::ParticleFlowObject *const pPfo, const size_t pfoId, size_t &nextId,
     anab::T0 &t0)
 {
     const pandora::ParticleFlowObject *const pParent(lar_content::LArPfoHelper::GetParentPfo(pPfo));
@@ -930,7 +1378,7 @@ bool LArPandoraOutput::BuildT0(const pandora::ParticleFlowObject *const pPfo, co
         return false;
 
     // Output T0 objects [arguments are:  time (nanoseconds);  trigger type (3 for TPC stitching!);  pfparticle SelfID code;  T0 ID code]
-    t0 = anab::T0(T0, 3, LArPandoraOutput::GetId(pPfo, pfoVector), nextId++);
+    t0 = anab::T0(T0, 3, pfoId, nextId++);
 
     return true;
 }
@@ -943,7 +1391,17 @@ LArPandoraOutput::Settings::Settings() :
     m_pProducer(nullptr),
     m_shouldRunStitching(false),
     m_shouldProduceAllOutcomes(false),
-    m_isNeutrinoRecoOnlyNoSlicing(false)
+    m_isNeutrinoRecoOnlyNoSlicing(false),
+    m_shouldBuildClustersInParallel(false),
+    m_clusterParameterLevel(kClusterFull),
+    m_shouldProduceSpacePoints(true),
+    m_shouldProduceClusters(true),
+    m_shouldProduceVertices(true),
+    m_shouldProduceMetadata(true),
+    m_shouldProduceSlices(true),
+    m_shouldProduceCompactSpacePoints(false),
+    m_compactSpacePointResolution(0.01f),
+    m_pInstrumentation(nullptr)
 {
 }
 
@@ -963,4 +1421,184 @@ void LArPandoraOutput::Settings::Validate() const
         throw cet::exception("LArPandora") << " LArPandoraOutput::Settings::Validate --- all outcomes instance label not set ";
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CaloHitResolutionTable::CaloHitResolutionTable(const IdToHitMap &idToHitMap, const size_t expectedSize) :
+    m_idToHitMap(idToHitMap),
+    m_size(0),
+    m_mask(0)
+{
+    size_t capacity(16);
+
+    while (capacity < 2 * expectedSize)
+        capacity *= 2;
+
+    this->Rehash(capacity);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const art::Ptr<recob::Hit> &CaloHitResolutionTable::GetHit(const pandora::CaloHit *const pCaloHit)
+{
+    const size_t slot(this->GetSlot(pCaloHit));
+
+    if (m_caloHitSlots[slot])
+        return *m_hitSlots[slot];
+
+    // ATTN Primary instance hits hold their hit id as the parent address, whilst daughter instance hits hold the address of the hit copied
+    pandora::CaloHitVector unresolvedHits;
+    const pandora::CaloHit *pCurrentCaloHit(pCaloHit);
+    const art::Ptr<recob::Hit> *pHit(nullptr);
+
+    for (unsigned int depth = 0; !pHit; ++depth)
+    {
+        if (!pCurrentCaloHit || (depth > m_maxDepth))
+            throw cet::exception("LArPandora") << " CaloHitResolutionTable::GetHit --- found a Pandora hit without a parent ART hit ";
+
+        const size_t currentSlot(this->GetSlot(pCurrentCaloHit));
+
+        if (m_caloHitSlots[currentSlot])
+        {
+            pHit = m_hitSlots[currentSlot];
+            break;
+        }
+
+        unresolvedHits.push_back(pCurrentCaloHit);
+
+        const intptr_t hitID((intptr_t)(pCurrentCaloHit->GetParentAddress()));
+        const IdToHitMap::const_iterator artIter((hitID > 0) && (hitID <= std::numeric_limits<int>::max()) ?
+            m_idToHitMap.find(static_cast<int>(hitID)) : m_idToHitMap.end());
+
+        if (m_idToHitMap.end() != artIter)
+        {
+            pHit = &artIter->second;
+            break;
+        }
+
+        pCurrentCaloHit = static_cast<const pandora::CaloHit*>(pCurrentCaloHit->GetParentAddress());
+    }
+
+    for (const pandora::CaloHit *const pUnresolvedHit : unresolvedHits)
+        this->Insert(pUnresolvedHit, pHit);
+
+    return *pHit;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+size_t CaloHitResolutionTable::GetSlot(const pandora::CaloHit *const pCaloHit) const
+{
+    // Fibonacci hashing of the address, with linear probing
+    const uint64_t hash((static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pCaloHit)) >> 3) * 0x9E3779B97F4A7C15ull);
+    size_t slot(static_cast<size_t>(hash ^ (hash >> 32)) & m_mask);
+
+    while (m_caloHitSlots[slot] && (m_caloHitSlots[slot] != pCaloHit))
+        slot = (slot + 1) & m_mask;
+
+    return slot;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CaloHitResolutionTable::Insert(const pandora::CaloHit *const pCaloHit, const art::Ptr<recob::Hit> *const pHit)
+{
+    // Keep the load factor at or below one half, so that probe sequences remain short
+    if (2 * (m_size + 1) > m_caloHitSlots.size())
+        this->Rehash(2 * m_caloHitSlots.size());
+
+    const size_t slot(this->GetSlot(pCaloHit));
+
+    if (m_caloHitSlots[slot])
+        throw cet::exception("LArPandora") << " CaloHitResolutionTable::Insert --- calo hit is already present in the table ";
+
+    m_caloHitSlots[slot] = pCaloHit;
+    m_hitSlots[slot] = pHit;
+    ++m_size;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CaloHitResolutionTable::Rehash(const size_t capacity)
+{
+    CaloHitSlots caloHitSlots(capacity, nullptr);
+    HitSlots hitSlots(capacity, nullptr);
+
+    caloHitSlots.swap(m_caloHitSlots);
+    hitSlots.swap(m_hitSlots);
+    m_mask = capacity - 1;
+    m_size = 0;
+
+    for (size_t iSlot = 0, nSlots = caloHitSlots.size(); iSlot < nSlots; ++iSlot)
+    {
+        if (!caloHitSlots[iSlot])
+            continue;
+
+        const size_t slot(this->GetSlot(caloHitSlots[iSlot]));
+        m_caloHitSlots[slot] = caloHitSlots[iSlot];
+        m_hitSlots[slot] = hitSlots[iSlot];
+        ++m_size;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const recob::Cluster *ClusterCache::Find(const ClusterHits &clusterHits) const
+{
+    HitKeyVector hitKeys, isolatedHitKeys;
+    ClusterCache::GetSortedHitKeys(clusterHits.first, hitKeys);
+    ClusterCache::GetSortedHitKeys(clusterHits.second, isolatedHitKeys);
+
+    EntryMap::const_iterator iter(m_entries.find(ClusterCache::GetKey(hitKeys, isolatedHitKeys)));
+
+    // ATTN Different clusters may share a key, so the hits are compared in full
+    if ((m_entries.end() == iter) || (iter->second.m_hitKeys != hitKeys) || (iter->second.m_isolatedHitKeys != isolatedHitKeys))
+        return nullptr;
+
+    return &(iter->second.m_cluster);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ClusterCache::Add(const ClusterHits &clusterHits, const recob::Cluster &cluster)
+{
+    HitKeyVector hitKeys, isolatedHitKeys;
+    ClusterCache::GetSortedHitKeys(clusterHits.first, hitKeys);
+    ClusterCache::GetSortedHitKeys(clusterHits.second, isolatedHitKeys);
+
+    Entry &entry(m_entries[ClusterCache::GetKey(hitKeys, isolatedHitKeys)]);
+    entry.m_cluster = cluster;
+    entry.m_hitKeys.swap(hitKeys);
+    entry.m_isolatedHitKeys.swap(isolatedHitKeys);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ClusterCache::GetSortedHitKeys(const HitVector &hitVector, HitKeyVector &hitKeys)
+{
+    hitKeys.clear();
+    hitKeys.reserve(hitVector.size());
+
+    for (const art::Ptr<recob::Hit> &hit : hitVector)
+        hitKeys.push_back(hit.key());
+
+    std::sort(hitKeys.begin(), hitKeys.end());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+size_t ClusterCache::GetKey(const HitKeyVector &hitKeys, const HitKeyVector &isolatedHitKeys)
+{
+    size_t key(std::hash<size_t>()(isolatedHitKeys.size()));
+
+    for (const HitKeyVector *const pHitKeys : {&hitKeys, &isolatedHitKeys})
+    {
+        for (const size_t hitKey : *pHitKeys)
+            key ^= std::hash<size_t>()(hitKey) + 0x9e3779b9 + (key << 6) + (key >> 2);
+    }
+
+    return key;
+}
+
 } // namespace lar_pandora
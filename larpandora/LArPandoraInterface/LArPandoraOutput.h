@@ -15,12 +15,18 @@
 
 #include "larreco/RecoAlg/ClusterRecoUtil/ClusterParamsAlgBase.h"
 
+#include "larpandora/LArPandoraObjects/CompactSpacePoints.h"
+
 #include "larpandora/LArPandoraInterface/ILArPandora.h"
 #include "larpandora/LArPandoraInterface/LArPandoraHelper.h"
+#include "larpandora/LArPandoraInterface/LArPandoraInstrumentation.h"
 
 #include "Pandora/PandoraInternal.h"
 
-namespace art {class EDProducer;}
+#include <array>
+#include <unordered_map>
+
+namespace art {class Modifier;}
 namespace pandora {class Pandora;}
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -28,13 +34,217 @@ namespace pandora {class Pandora;}
 namespace lar_pandora
 {
 
+/**
+ *  @brief  CaloHitResolutionTable class, an open-addressing hash table resolving calo hits from any pandora instance to their ART hits
+ */
+class CaloHitResolutionTable
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  idToHitMap the mapping from Pandora hit ID to ART hit, which must outlive the table
+     *  @param  expectedSize the expected number of distinct calo hits to be resolved
+     */
+    CaloHitResolutionTable(const IdToHitMap &idToHitMap, const size_t expectedSize);
+
+    /**
+     *  @brief  Get the ART hit underlying a 2D calo hit, following parent calo hits through any depth of daughter instances.
+     *          Each calo hit visited is recorded, so that later requests for it, or for its copies, need a single lookup
+     *
+     *  @param  pCaloHit the input Pandora hit (2D)
+     *
+     *  @return the ART hit
+     */
+    const art::Ptr<recob::Hit> &GetHit(const pandora::CaloHit *const pCaloHit);
+
+private:
+    /**
+     *  @brief  Get the slot holding a calo hit, or the empty slot at which it should be inserted
+     *
+     *  @param  pCaloHit the calo hit
+     */
+    size_t GetSlot(const pandora::CaloHit *const pCaloHit) const;
+
+    /**
+     *  @brief  Record the ART hit for a calo hit that is not already in the table
+     *
+     *  @param  pCaloHit the calo hit
+     *  @param  pHit the address of the ART hit, within the id to hit map
+     */
+    void Insert(const pandora::CaloHit *const pCaloHit, const art::Ptr<recob::Hit> *const pHit);
+
+    /**
+     *  @brief  Rebuild the table with a new capacity
+     *
+     *  @param  capacity the new capacity, which must be a power of two
+     */
+    void Rehash(const size_t capacity);
+
+    typedef std::vector<const pandora::CaloHit*> CaloHitSlots;
+    typedef std::vector<const art::Ptr<recob::Hit>*> HitSlots;
+
+    static const unsigned int   m_maxDepth = 64;        ///< The maximum depth of parent calo hits to follow, guarding against cycles
+
+    const IdToHitMap           &m_idToHitMap;           ///< The mapping from Pandora hit ID to ART hit
+    CaloHitSlots                m_caloHitSlots;         ///< The calo hit in each slot, nullptr for empty slots
+    HitSlots                    m_hitSlots;             ///< The address of the ART hit for each slot
+    size_t                      m_size;                 ///< The number of occupied slots
+    size_t                      m_mask;                 ///< The capacity minus one
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  AssociationBuilder class, appending associations between objects of two ART products to an output collection.
+ *          The ptr makers are created once, on first use, rather than for every association added
+ */
+template <typename A, typename B>
+class AssociationBuilder
+{
+public:
+    typedef std::unique_ptr< art::Assns<A, B> > AssociationCollection;
+
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  event the ART event, which must outlive the builder
+     *  @param  instanceLabel the label for the collections to be produced
+     *  @param  association the output association to update, which must outlive the builder
+     */
+    AssociationBuilder(const art::Event &event, const std::string &instanceLabel, AssociationCollection &association);
+
+    /**
+     *  @brief  Add an association between objects with two given ids
+     *
+     *  @param  idA the id of an object of type A
+     *  @param  idB the id of an object of type B to associate to the first object
+     */
+    void Add(const size_t idA, const size_t idB);
+
+    /**
+     *  @brief  Add an association between an object with a given id and an existing object
+     *
+     *  @param  idA the id of an object of type A
+     *  @param  pB the object of type B to associate to the first object
+     */
+    void Add(const size_t idA, const art::Ptr<B> &pB);
+
+    /**
+     *  @brief  Add associations between an object and a block of objects with given ids
+     *
+     *  @param  idA the id of an object of type A
+     *  @param  idBVector the input vector of IDs of objects of type B to associate
+     */
+    void Add(const size_t idA, const std::vector<size_t> &idBVector);
+
+    /**
+     *  @brief  Add associations between an object and a block of existing objects
+     *
+     *  @param  idA the id of an object of type A
+     *  @param  bVector the input vector of objects of type B to associate
+     */
+    void Add(const size_t idA, const std::vector< art::Ptr<B> > &bVector);
+
+private:
+    /**
+     *  @brief  Get the ptr maker for a product, creating it if required
+     *
+     *  @param  pPtrMaker the cached ptr maker
+     */
+    template <typename T>
+    const art::PtrMaker<T> &GetPtrMaker(std::unique_ptr< const art::PtrMaker<T> > &pPtrMaker) const;
+
+    const art::Event                               &m_event;            ///< The ART event
+    const std::string                               m_instanceLabel;    ///< The label for the collections to be produced
+    AssociationCollection                          &m_association;      ///< The output association
+    std::unique_ptr< const art::PtrMaker<A> >       m_pPtrMakerA;       ///< The ptr maker for objects of type A
+    std::unique_ptr< const art::PtrMaker<B> >       m_pPtrMakerB;       ///< The ptr maker for objects of type B, only used when adding by id
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  ClusterCache class, holding the ART clusters built for one output instance, so that the identical clusters of a later instance in
+ *          the same event need not be rebuilt. Entries are keyed by a hash of the keys of the cluster hits, and are confirmed by the number
+ *          and the first of the hits, so the hits themselves are not stored
+ */
+class ClusterCache
+{
+public:
+    typedef std::pair<HitVector, HitVector> ClusterHits;
+
+    /**
+     *  @brief  Find the ART cluster built from a given set of hits
+     *
+     *  @param  clusterHits the hits, and isolated hits, of the cluster
+     *
+     *  @return the address of the cached cluster, nullptr if there is no such cluster
+     */
+    const recob::Cluster *Find(const ClusterHits &clusterHits) const;
+
+    /**
+     *  @brief  Add the ART cluster built from a given set of hits, replacing any entry with the same key
+     *
+     *  @param  clusterHits the hits, and isolated hits, of the cluster
+     *  @param  cluster the cluster
+     */
+    void Add(const ClusterHits &clusterHits, const recob::Cluster &cluster);
+
+private:
+    typedef std::vector<size_t> HitKeyVector;
+
+    /**
+     *  @brief  Entry class, holding a cached cluster and the sorted keys of the hits from which it was built, used to confirm a match
+     */
+    class Entry
+    {
+    public:
+        recob::Cluster          m_cluster;              ///< The cluster
+        HitKeyVector            m_hitKeys;              ///< The sorted keys of the hits in the cluster
+        HitKeyVector            m_isolatedHitKeys;      ///< The sorted keys of the isolated hits in the cluster
+    };
+
+    /**
+     *  @brief  Get the sorted keys of a vector of hits
+     *
+     *  @param  hitVector the vector of hits
+     *  @param  hitKeys to receive the sorted keys
+     */
+    static void GetSortedHitKeys(const HitVector &hitVector, HitKeyVector &hitKeys);
+
+    /**
+     *  @brief  Get the key for a cluster, a hash of the sorted keys of its hits and of its isolated hits
+     *
+     *  @param  hitKeys the sorted keys of the hits in the cluster
+     *  @param  isolatedHitKeys the sorted keys of the isolated hits in the cluster
+     */
+    static size_t GetKey(const HitKeyVector &hitKeys, const HitKeyVector &isolatedHitKeys);
+
+    typedef std::unordered_map<size_t, Entry> EntryMap;
+
+    EntryMap                    m_entries;              ///< The cached clusters, keyed by the hash of their hits
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 class LArPandoraOutput
 {
 public:
     typedef std::vector<size_t> IdVector;
     typedef std::map<size_t, IdVector> IdToIdVectorMap;
     typedef std::map<const pandora::CaloHit *, art::Ptr<recob::Hit> > CaloHitToArtHitMap;
+    typedef std::unordered_map<const pandora::ParticleFlowObject *, size_t> PfoToIdMap;
+    typedef std::unordered_map<const pandora::Cluster *, size_t> ClusterToIdMap;
+    typedef std::unordered_map<const pandora::Vertex *, size_t> VertexToIdMap;
+    typedef ClusterCache::ClusterHits ClusterHits;
   
+    typedef std::array<double, 3> Vector3;
+    typedef std::array<Vector3, 3> Matrix3;
+
     typedef std::unique_ptr< std::vector<recob::PFParticle> > PFParticleCollection;
     typedef std::unique_ptr< std::vector<recob::Vertex> > VertexCollection;
     typedef std::unique_ptr< std::vector<recob::Cluster> > ClusterCollection;
@@ -42,6 +252,7 @@ public:
     typedef std::unique_ptr< std::vector<anab::T0> > T0Collection;
     typedef std::unique_ptr< std::vector<larpandoraobj::PFParticleMetadata> > PFParticleMetadataCollection;
     typedef std::unique_ptr< std::vector<recob::Slice> > SliceCollection;
+    typedef std::unique_ptr< larpandoraobj::CompactSpacePoints > CompactSpacePointsCollection;
 
     typedef std::unique_ptr< art::Assns<recob::PFParticle, larpandoraobj::PFParticleMetadata> > PFParticleToMetadataCollection;
     typedef std::unique_ptr< art::Assns<recob::PFParticle, recob::SpacePoint> > PFParticleToSpacePointCollection;
@@ -54,6 +265,19 @@ public:
     typedef std::unique_ptr< art::Assns<recob::SpacePoint, recob::Hit> > SpacePointToHitCollection;
     typedef std::unique_ptr< art::Assns<recob::Slice, recob::Hit> > SliceToHitCollection;
 
+    typedef AssociationBuilder<recob::PFParticle, recob::Slice> PFParticleToSliceBuilder;
+    typedef AssociationBuilder<recob::Slice, recob::Hit> SliceToHitBuilder;
+
+    /**
+     *  @brief  ClusterParameterLevel enumeration, the extent of the ART cluster parameters to calculate
+     */
+    enum ClusterParameterLevel
+    {
+        kClusterPositions = 0,   // Only the start and end positions, the view, the plane and the number of hits
+        kClusterCharge = 1,      // Additionally the hit integral and summed ADC totals, with their standard deviations
+        kClusterFull = 2         // All parameters, calculated using the cluster parameter algorithm
+    };
+
     /**
      *  @brief  Settings class
      */
@@ -71,12 +295,22 @@ public:
         void Validate() const;
 
         const pandora::Pandora *m_pPrimaryPandora;              ///<
-        art::EDProducer        *m_pProducer;                    ///<
+        art::Modifier          *m_pProducer;                    ///<
         bool                    m_shouldRunStitching;           ///<
         bool                    m_shouldProduceAllOutcomes;     ///< If all outcomes should be produced in separate collections (choose false if you only require the consolidated output)
         std::string             m_allOutcomesInstanceLabel;     ///< The label for the instance producing all outcomes
         bool                    m_isNeutrinoRecoOnlyNoSlicing;  ///< If we are running the neutrino reconstruction only with no slicing
         std::string             m_hitfinderModuleLabel;         ///< The hit finder module label
+        bool                    m_shouldBuildClustersInParallel;///< Whether to calculate the ART cluster parameters concurrently, not at the full level
+        ClusterParameterLevel   m_clusterParameterLevel;        ///< The extent of the ART cluster parameters to calculate
+        bool                    m_shouldProduceSpacePoints;     ///< Whether to produce space points, and their associations to particles and hits
+        bool                    m_shouldProduceClusters;        ///< Whether to produce clusters, and their associations to particles and hits
+        bool                    m_shouldProduceVertices;        ///< Whether to produce vertices, and their associations to particles
+        bool                    m_shouldProduceMetadata;        ///< Whether to produce particle metadata, and their associations to particles
+        bool                    m_shouldProduceSlices;          ///< Whether to produce slices, and their associations to particles and hits
+        bool                    m_shouldProduceCompactSpacePoints; ///< Whether to produce the compact, quantised 3D hit positions of each particle
+        float                   m_compactSpacePointResolution;  ///< The coordinate resolution of the compact 3D hit positions (cm)
+        LArPandoraInstrumentation *m_pInstrumentation;          ///< The address of the stage timing instrumentation, nullptr if disabled
     };
 
     /**
@@ -88,7 +322,34 @@ public:
      */
     static void ProduceArtOutput(const Settings &settings, const IdToHitMap &idToHitMap, art::Event &evt);
 
-private:
+    /**
+     *  @brief  Convert the Pandora PFOs into both the consolidated and the all outcomes ART products, and write them into the ART event.
+     *          The hit resolution and the cluster parameters computed for the all outcomes products are reused for the consolidated products
+     *
+     *  @param  settings the settings
+     *  @param  idToHitMap the mapping from Pandora hit ID to ART hit
+     *  @param  evt the ART event
+     */
+    static void ProduceCombinedArtOutput(const Settings &settings, const IdToHitMap &idToHitMap, art::Event &evt);
+
+    /**
+     *  @brief  Write empty ART products, of the types enabled in the settings, into the ART event
+     *
+     *  @param  settings the settings
+     *  @param  instanceLabel the label for the collections to be produced
+     *  @param  evt the ART event
+     */
+    static void ProduceEmptyArtOutput(const Settings &settings, const std::string &instanceLabel, art::Event &evt);
+
+    /**
+     *  @brief  Get the cluster parameter level corresponding to its configuration name
+     *
+     *  @param  name the name of the level: "Positions", "Charge" or "Full"
+     *
+     *  @return the cluster parameter level
+     */
+    static ClusterParameterLevel GetClusterParameterLevel(const std::string &name);
+
     /**
      *  @brief  Get the address of a pandora instance with a given name
      *
@@ -109,6 +370,20 @@ private:
      */
     static void GetPandoraSlices(const pandora::Pandora *const pPrimaryPandora, pandora::PfoVector &slicePfos);
 
+private:
+    /**
+     *  @brief  Convert a vector of Pandora PFOs into ART products with a given instance label, and write them into the ART event
+     *
+     *  @param  settings the settings
+     *  @param  instanceLabel the label for the collections to be produced
+     *  @param  pfoVector the input vector of all pfos to be output
+     *  @param  caloHitResolutionTable input/output table resolving pandora hits to ART hits
+     *  @param  pClusterCache the address of the input/output cache of the ART clusters already built, nullptr for no cache
+     *  @param  evt the ART event
+     */
+    static void ProduceArtOutput(const Settings &settings, const std::string &instanceLabel, const pandora::PfoVector &pfoVector,
+        CaloHitResolutionTable &caloHitResolutionTable, ClusterCache *const pClusterCache, art::Event &evt);
+
     /**
      *  @brief  Check if the input pfo is an unambiguous cosmic ray
      *
@@ -204,45 +479,35 @@ private:
     static pandora::CaloHitList Collect3DHits(const pandora::PfoVector &pfoVector, IdToIdVectorMap &pfoToThreeDHitsMap);
 
     /**
-     *  @brief  Find the index of an input object in an input list. Throw an exception if it doesn't exist
+     *  @brief  Build the mapping from each object in an input list or vector to its index. Only the first occurrence of each object is indexed
      *
-     *  @param  pT the input object for which the ID should be found
-     *  @param  tList a list of objects of type pT to query
-     *  
-     *  @return the ID of the input object
+     *  @param  tContainer a list or vector of objects to index
+     *  @param  tToIdMap the output mapping from object to index
      */
-    template <typename T>
-    static size_t GetId(const T *const pT, const std::list<const T*> &tList);
-    
+    template <typename T, typename C>
+    static void GetIdMap(const C &tContainer, std::unordered_map<const T*, size_t> &tToIdMap);
+
     /**
-     *  @brief  Find the index of an input object in an input vector. Throw an exception if it doesn't exist
+     *  @brief  Find the index of an input object using a precomputed mapping. Throw an exception if it doesn't exist
      *
      *  @param  pT the input object for which the ID should be found
-     *  @param  tVector a list of objects of type pT to query
+     *  @param  tToIdMap the mapping from object to index, as built by GetIdMap
      *  
      *  @return the ID of the input object
      */
     template <typename T>
-    static size_t GetId(const T *const pT, const std::vector<const T*> &tVector);
+    static size_t GetId(const T *const pT, const std::unordered_map<const T*, size_t> &tToIdMap);
     
     /**
      *  @brief  Collect all 2D and 3D hits that were used / produced in the reconstruction and map them to their corresponding ART hit
      *
      *  @param  clusterList input list of all 2D clusters to be output
      *  @param  threeDHitList input list of all 3D hits to be output (as spacepoints)
-     *  @param  idToHitMap input mapping from pandora hit ID to ART hit
+     *  @param  caloHitResolutionTable input/output table resolving pandora hits to ART hits
      *  @param  pandoraHitToArtHitMap output mapping from pandora hit to ART hit
      */
     static void GetPandoraToArtHitMap(const pandora::ClusterList &clusterList, const pandora::CaloHitList &threeDHitList,
-        const IdToHitMap &idToHitMap, CaloHitToArtHitMap &pandoraHitToArtHitMap);
-
-    /**
-     *  @brief  Look up ART hit from an input Pandora hit
-     *
-     *  @param  idToHitMap the mapping between Pandora and ART hits
-     *  @param  pCaloHit the input Pandora hit (2D)
-     */
-    static art::Ptr<recob::Hit> GetHit(const IdToHitMap &idToHitMap, const pandora::CaloHit *const pCaloHit);
+        CaloHitResolutionTable &caloHitResolutionTable, CaloHitToArtHitMap &pandoraHitToArtHitMap);
 
     /**
      *  @brief  Convert pandora vertices to ART vertices and add them to the output vector
@@ -263,10 +528,21 @@ private:
      *  @param  outputSpacePoints the output vector of spacepoints
      *  @param  outputSpacePointsToHits the output associations between spacepoints and hits
      */
-    static void BuildSpacePoints(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel,
+    static void BuildSpacePoints(const art::Event &event, const art::Modifier *const pProducer, const std::string &instanceLabel,
         const pandora::CaloHitList &threeDHitList, const CaloHitToArtHitMap &pandoraHitToArtHitMap, SpacePointCollection &outputSpacePoints,
         SpacePointToHitCollection &outputSpacePointsToHits);
 
+    /**
+     *  @brief  Store the positions of the pandora 3D hits of each pfo in the compact, quantised format
+     *
+     *  @param  nPfos the number of pfos
+     *  @param  threeDHitList the input list of 3D hits
+     *  @param  pfoToThreeDHitsMap the input mapping from pfo ID to 3D hit IDs
+     *  @param  outputCompactSpacePoints the output compact 3D hit positions, with one entry per pfo
+     */
+    static void BuildCompactSpacePoints(const size_t nPfos, const pandora::CaloHitList &threeDHitList, const IdToIdVectorMap &pfoToThreeDHitsMap,
+        CompactSpacePointsCollection &outputCompactSpacePoints);
+
     /**
      *  @brief  Convert pandora 2D clusters to ART clusters and add them to the output vector
      *          Create the associations between clusters and hits.
@@ -275,15 +551,20 @@ private:
      *  @param  event the art event
      *  @param  pProducer the address of the producer module
      *  @param  clusterList the input list of 2D pandora clusters to convert
+     *  @param  clusterToIdMap the input mapping from pandora cluster to cluster ID
      *  @param  pandoraHitToArtHitMap the input mapping from pandora hits to ART hits
      *  @param  pfoToClustersMap the input mapping from pfo ID to cluster IDs
+     *  @param  pClusterCache the address of the input/output cache of the ART clusters already built, nullptr for no cache
+     *  @param  shouldBuildInParallel whether to calculate the parameters of the ART clusters concurrently, ignored for the full parameter level
+     *  @param  clusterParameterLevel the extent of the ART cluster parameters to calculate
      *  @param  outputClusters the output vector of clusters
      *  @param  outputClustersToHits the output associations between clusters and hits
      *  @param  pfoToArtClustersMap the output mapping from pfo ID to art cluster ID
      */
-    static void BuildClusters(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel,
-        const pandora::ClusterList &clusterList, const CaloHitToArtHitMap &pandoraHitToArtHitMap, const IdToIdVectorMap &pfoToClustersMap,
-        ClusterCollection &outputClusters, ClusterToHitCollection &outputClustersToHits, IdToIdVectorMap &pfoToArtClustersMap);
+    static void BuildClusters(const art::Event &event, const art::Modifier *const pProducer, const std::string &instanceLabel,
+        const pandora::ClusterList &clusterList, const ClusterToIdMap &clusterToIdMap, const CaloHitToArtHitMap &pandoraHitToArtHitMap,
+        const IdToIdVectorMap &pfoToClustersMap, ClusterCache *const pClusterCache, const bool shouldBuildInParallel,
+        const ClusterParameterLevel clusterParameterLevel, ClusterCollection &outputClusters, ClusterToHitCollection &outputClustersToHits, IdToIdVectorMap &pfoToArtClustersMap);
 
     /**
      *  @brief  Convert between pfos and PFParticles and add them to the output vector
@@ -292,6 +573,7 @@ private:
      *  @param  event the art event
      *  @param  pProducer the address of the producer module
      *  @param  pfoVector the input list of pfos to convert
+     *  @param  pfoToIdMap the input mapping from pfo to pfo ID
      *  @param  pfoToVerticesMap the input mapping from pfo ID to vertex IDs
      *  @param  pfoToThreeDHitsMap the input mapping from pfo ID to 3D hit IDs
      *  @param  pfoToArtClustersMap the input mapping from pfo ID to ART cluster IDs
@@ -300,8 +582,8 @@ private:
      *  @param  outputParticlesToSpacePoints the output associations between PFParticles and spacepoints
      *  @param  outputParticlesToClusters the output associations between PFParticles and clusters
      */
-    static void BuildPFParticles(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel,
-        const pandora::PfoVector &pfoVector, const IdToIdVectorMap &pfoToVerticesMap, const IdToIdVectorMap &pfoToThreeDHitsMap, 
+    static void BuildPFParticles(const art::Event &event, const art::Modifier *const pProducer, const std::string &instanceLabel,
+        const pandora::PfoVector &pfoVector, const PfoToIdMap &pfoToIdMap, const IdToIdVectorMap &pfoToVerticesMap, const IdToIdVectorMap &pfoToThreeDHitsMap,
         const IdToIdVectorMap &pfoToArtClustersMap, PFParticleCollection &outputParticles, 
         PFParticleToVertexCollection &outputParticlesToVertices, PFParticleToSpacePointCollection &outputParticlesToSpacePoints,
         PFParticleToClusterCollection &outputParticlesToClusters);
@@ -315,7 +597,7 @@ private:
      *  @param  outputParticleMetadata the output vector of PFParticleMetadata
      *  @param  outputParticlesToMetadata the output associations between PFParticles and metadata
      */
-    static void BuildParticleMetadata(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel, 
+    static void BuildParticleMetadata(const art::Event &event, const art::Modifier *const pProducer, const std::string &instanceLabel, 
         const pandora::PfoVector &pfoVector, PFParticleMetadataCollection &outputParticleMetadata,
         PFParticleToMetadataCollection &outputParticlesToMetadata);
 
@@ -328,14 +610,14 @@ private:
      *  @param  pProducer the address of the pandora producer 
      *  @param  instanceLabel the label for the collections to be produced
      *  @param  pfoVector the input vector of all pfos to be output
-     *  @param  idToHitMap input mapping from pandora hit ID to ART hit
+     *  @param  caloHitResolutionTable input/output table resolving pandora hits to ART hits
      *  @param  outputSlices the output collection of slices to populate
      *  @param  outputParticlesToSlices the output association from particles to slices
      *  @param  outputSlicesToHits the output association from slices to hits
      */
     static void BuildSlices(const Settings &settings, const pandora::Pandora *const pPrimaryPandora, const art::Event &event,
-    const art::EDProducer *const pProducer, const std::string &instanceLabel, const pandora::PfoVector &pfoVector, 
-    const IdToHitMap &idToHitMap, SliceCollection &outputSlices, PFParticleToSliceCollection &outputParticlesToSlices,
+    const art::Modifier *const pProducer, const std::string &instanceLabel, const pandora::PfoVector &pfoVector, 
+    CaloHitResolutionTable &caloHitResolutionTable, SliceCollection &outputSlices, PFParticleToSliceCollection &outputParticlesToSlices,
     SliceToHitCollection &outputSlicesToHits);
 
     /**
@@ -350,32 +632,47 @@ private:
      *
      *  @param  settings the settings
      *  @param  event the art event
-     *  @param  pProducer the address of the pandora producer 
-     *  @param  instanceLabel the label for the collections to be produced
      *  @param  pfoVector the input vector of all pfos to be output
-     *  @param  idToHitMap input mapping from pandora hit ID to ART hit
      *  @param  outputSlices the output collection of slices to populate
-     *  @param  outputParticlesToSlices the output association from particles to slices
-     *  @param  outputSlicesToHits the output association from slices to hits
+     *  @param  particleToSliceBuilder the builder of the output association from particles to slices
+     *  @param  sliceToHitBuilder the builder of the output association from slices to hits
      */
-    static void CopyAllHitsToSingleSlice(const Settings &settings, const art::Event &event, const art::EDProducer *const pProducer,
-    const std::string &instanceLabel, const pandora::PfoVector &pfoVector, const IdToHitMap &idToHitMap, SliceCollection &outputSlices,
-    PFParticleToSliceCollection &outputParticlesToSlices, SliceToHitCollection &outputSlicesToHits);
+    static void CopyAllHitsToSingleSlice(const Settings &settings, const art::Event &event, const pandora::PfoVector &pfoVector,
+    SliceCollection &outputSlices, PFParticleToSliceBuilder &particleToSliceBuilder, SliceToHitBuilder &sliceToHitBuilder);
 
     /**
      *  @brief  Build a new slice object from a PFO, this can be a top-level parent in a hierarchy or a "slice PFO" from the slicing instance
      *
      *  @param  pParentPfo the parent pfo from which to build the slice
-     *  @param  event the art event
-     *  @param  pProducer the address of the pandora producer 
-     *  @param  instanceLabel the label for the collections to be produced
-     *  @param  idToHitMap input mapping from pandora hit ID to ART hit
+     *  @param  caloHitResolutionTable input/output table resolving pandora hits to ART hits
      *  @param  outputSlices the output collection of slices to populate
-     *  @param  outputSlicesToHits the output association from slices to hits
+     *  @param  sliceToHitBuilder the builder of the output association from slices to hits
      */
-    static unsigned int BuildSlice(const pandora::ParticleFlowObject *const pParentPfo, const art::Event &event,
-    const art::EDProducer *const pProducer, const std::string &instanceLabel, const IdToHitMap &idToHitMap, SliceCollection &outputSlices,
-    SliceToHitCollection &outputSlicesToHits);
+    static unsigned int BuildSlice(const pandora::ParticleFlowObject *const pParentPfo, CaloHitResolutionTable &caloHitResolutionTable,
+    SliceCollection &outputSlices, SliceToHitBuilder &sliceToHitBuilder);
+
+    /**
+     *  @brief  Build a slice object summarising its hits. The centre is the charge-weighted centroid of the 3D hits, the direction is
+     *          their principal axis and the end points are the 3D hits with the extremal projections onto that axis. The aspect ratio
+     *          is the ratio of the spreads along the second and first principal axes, and the charge is the summed integral of the 2D hits.
+     *          Quantities that can't be calculated, e.g. if the slice has no 3D hits, retain the dummy value
+     *
+     *  @param  sliceIndex the id code for the slice
+     *  @param  threeDHitList the input list of 3D hits in the slice
+     *  @param  sliceHits the input vector of ART hits in the slice
+     *
+     *  @return the slice
+     */
+    static recob::Slice BuildSliceSummary(const unsigned int sliceIndex, const pandora::CaloHitList &threeDHitList, const HitVector &sliceHits);
+
+    /**
+     *  @brief  Find the eigenvalues and eigenvectors of a real symmetric 3x3 matrix, using cyclic Jacobi rotations
+     *
+     *  @param  matrix the input matrix, which is diagonalised in place
+     *  @param  eigenValues the output eigenvalues
+     *  @param  eigenVectors the output eigenvectors, stored as the matrix columns in the order of the eigenvalues
+     */
+    static void DiagonaliseSymmetricMatrix(Matrix3 &matrix, Vector3 &eigenValues, Matrix3 &eigenVectors);
 
     /**
      *  @brief  Calculate the T0 of each pfos and add them to the output vector
@@ -388,7 +685,7 @@ private:
      *  @param  outputT0s the output vector of T0s
      *  @param  outputParticlesToT0s the output associations between PFParticles and T0s
      */
-    static void BuildT0s(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel,
+    static void BuildT0s(const art::Event &event, const art::Modifier *const pProducer, const std::string &instanceLabel,
         const pandora::PfoVector &pfoVector, T0Collection &outputT0s, PFParticleToT0Collection &outputParticlesToT0s);
 
     /**
@@ -420,20 +717,14 @@ private:
     static void GetHitsInCluster(const pandora::Cluster *const pCluster, pandora::CaloHitVector &sortedHits);
 
     /**
-     *  @brief  Convert from a pandora 2D cluster to a vector of ART clusters (produce multiple if the cluster is split over drift volumes)
+     *  @brief  Collect the ART hits for each ART cluster to be produced from a pandora 2D cluster (multiple if the cluster is split over drift volumes)
      *
      *  @param  pCluster the input cluster
-     *  @param  clusterList the input list of clusters
      *  @param  pandoraHitToArtHitMap the input mapping from pandora hits to ART hits
-     *  @param  pandoraClusterToArtClustersMap output mapping from pandora cluster ID to art cluster IDs
-     *  @param  hitVectors the output vectors of hits for each cluster produced used to produce associations
-     *  @param  algo algorithm set to fill cluster members
-     *
-     *  @param  the vector of ART clusters
+     *  @param  clusterHitsVector the output hits, and isolated hits, for each ART cluster
      */
-    static std::vector<recob::Cluster> BuildClusters(const pandora::Cluster *const pCluster, const pandora::ClusterList &clusterList,
-        const CaloHitToArtHitMap &pandoraHitToArtHitMap, IdToIdVectorMap &pandoraClusterToArtClustersMap, std::vector<HitVector> &hitVectors,
-        size_t &nextId, cluster::ClusterParamsAlgBase &algo);
+    static void GetClusterHits(const pandora::Cluster *const pCluster, const CaloHitToArtHitMap &pandoraHitToArtHitMap,
+        std::vector<ClusterHits> &clusterHitsVector);
 
     /**
      *  @brief  Build an ART cluster from an input vector of ART hits
@@ -442,152 +733,146 @@ private:
      *  @param  hitVector the input vector of hits
      *  @param  isolatedHits the input list of isolated hits
      *  @param  algo algorithm set to fill cluster members
+     *  @param  clusterParameterLevel the extent of the cluster parameters to calculate; the algorithm is only used for the full level
      * 
      *  @return the ART cluster
      *
      *  If you don't know which algorithm to pick, StandardClusterParamsAlg is a good default.
      *  The hits that are isolated (that is, present in isolatedHits) are not fed to the cluster parameter algorithms.
+     *  Parameters beyond the requested level are left at zero.
      */
     static recob::Cluster BuildCluster(const size_t id, const HitVector &hitVector, const HitList &isolatedHits,
-        cluster::ClusterParamsAlgBase &algo);
+        cluster::ClusterParamsAlgBase &algo, const ClusterParameterLevel clusterParameterLevel = kClusterFull);
+
+    /**
+     *  @brief  Copy an ART cluster, assigning it a new id code
+     *
+     *  @param  cluster the input cluster
+     *  @param  id the id code for the copy
+     *
+     *  @return the copied ART cluster
+     */
+    static recob::Cluster CopyCluster(const recob::Cluster &cluster, const size_t id);
 
     /**
      *  @brief  Convert from a pfo to and ART PFParticle
      *
      *  @param  pPfo the input pfo to convert
      *  @param  pfoId the id of the pfo to produce
-     *  @param  pfoVector the input list of pfos
+     *  @param  pfoToIdMap the input mapping from pfo to pfo ID
      *
      *  @param  the ART PFParticle
      */
-    static recob::PFParticle BuildPFParticle(const pandora::ParticleFlowObject *const pPfo, const size_t pfoId, const pandora::PfoVector &pfoVector);
+    static recob::PFParticle BuildPFParticle(const pandora::ParticleFlowObject *const pPfo, const size_t pfoId, const PfoToIdMap &pfoToIdMap);
 
     /**
      *  @brief  If required, build a T0 for the input pfo
      *
      *  @param  pPfo the input pfo
-     *  @param  pfoVector the input list of pfos
+     *  @param  pfoId the id of the input pfo
      *  @param  nextId the ID of the T0 - will be incremented if the t0 was produced
      *  @param  t0 the output T0
      *
      *  @return if a T0 was produced (calculated from the stitching hit shift distance)
      */
-    static bool BuildT0(const pandora::ParticleFlowObject *const pPfo, const pandora::PfoVector &pfoVector, size_t &nextId, anab::T0 &t0);
+    static bool BuildT0(const pandora::ParticleFlowObject *const pPfo, const size_t pfoId, size_t &nextId, anab::T0 &t0);
+};
 
-    /**
-     *  @brief  Add an association between objects with two given ids
-     *
-     *  @param  event the ART event
-     *  @param  pProducer the address of the producer module
-     *  @param  idA the id of an object of type A
-     *  @param  idB the id of an object of type B to associate to the first object
-     *  @param  association the output association to update
-     */
-    template <typename A, typename B>
-    static void AddAssociation(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel,
-        const size_t idA, const size_t idB, std::unique_ptr< art::Assns<A, B> > &association);
+//------------------------------------------------------------------------------------------------------------------------------------------
 
-    /**
-     *  @brief  Add associations between input objects
-     *
-     *  @param  event the ART event
-     *  @param  pProducer the address of the producer module
-     *  @param  idA the id of an object of type A
-     *  @param  aToBMap the input mapping from IDs of objects of type A to IDs of objects of type B to associate
-     *  @param  association the output association to update
-     */
-    template <typename A, typename B>
-    static void AddAssociation(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel,
-        const size_t idA, const IdToIdVectorMap &aToBMap, std::unique_ptr< art::Assns<A, B> > &association);
+template <typename T, typename C>
+inline void LArPandoraOutput::GetIdMap(const C &tContainer, std::unordered_map<const T*, size_t> &tToIdMap)
+{
+    if (!tToIdMap.empty())
+        throw cet::exception("LArPandora") << " LArPandoraOutput::GetIdMap --- trying to fill a non-empty map ";
 
-    /**
-     *  @brief  Add associations between input objects
-     *
-     *  @param  event the ART event
-     *  @param  pProducer the address of the producer module
-     *  @param  idA the id of an object of type A
-     *  @param  bVector the input vector of IDs of objects of type B to associate
-     *  @param  association the output association to update
-     */
-    template <typename A, typename B>
-    static void AddAssociation(const art::Event &event, const art::EDProducer *const pProducer, const std::string &instanceLabel,
-        const size_t idA, const std::vector< art::Ptr<B> > &bVector, std::unique_ptr< art::Assns<A, B> > &association);
-};
+    tToIdMap.reserve(tContainer.size());
+
+    size_t id(0);
+    for (const T *const pT : tContainer)
+        tToIdMap.emplace(pT, id++);
+}
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename T>
-inline size_t LArPandoraOutput::GetId(const T *const pT, const std::list<const T*> &tList)
+inline size_t LArPandoraOutput::GetId(const T *const pT, const std::unordered_map<const T*, size_t> &tToIdMap)
 {
-    typename std::list<const T*>::const_iterator it(std::find(tList.begin(), tList.end(), pT));
+    typename std::unordered_map<const T*, size_t>::const_iterator it(tToIdMap.find(pT));
 
-    if (it == tList.end())
+    if (it == tToIdMap.end())
         throw cet::exception("LArPandora") << " LArPandoraOutput::GetId --- can't find the id of supplied object";
 
-    return static_cast<size_t>(std::distance(tList.begin(), it));
+    return it->second;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-template <typename T>
-inline size_t LArPandoraOutput::GetId(const T *const pT, const std::vector<const T*> &tVector)
+template <typename A, typename B>
+inline AssociationBuilder<A, B>::AssociationBuilder(const art::Event &event, const std::string &instanceLabel, AssociationCollection &association) :
+    m_event(event),
+    m_instanceLabel(instanceLabel),
+    m_association(association)
 {
-    typename std::vector<const T*>::const_iterator it(std::find(tVector.begin(), tVector.end(), pT));
+}
 
-    if (it == tVector.end())
-        throw cet::exception("LArPandora") << " LArPandoraOutput::GetId --- can't find the id of supplied object";
+//------------------------------------------------------------------------------------------------------------------------------------------
 
-    return static_cast<size_t>(std::distance(tVector.begin(), it));
+template <typename A, typename B>
+inline void AssociationBuilder<A, B>::Add(const size_t idA, const size_t idB)
+{
+    m_association->addSingle(this->GetPtrMaker(m_pPtrMakerA)(idA), this->GetPtrMaker(m_pPtrMakerB)(idB));
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-    
+
 template <typename A, typename B>
-inline void LArPandoraOutput::AddAssociation(const art::Event &event, const art::EDProducer *const,
-    const std::string &instanceLabel, const size_t idA, const size_t idB, std::unique_ptr< art::Assns<A, B> > &association)
+inline void AssociationBuilder<A, B>::Add(const size_t idA, const art::Ptr<B> &pB)
 {
-    const art::PtrMaker<A> makePtrA(event, instanceLabel);
-    art::Ptr<A> pA(makePtrA(idA));
-
-    const art::PtrMaker<B> makePtrB(event, instanceLabel);
-    art::Ptr<B> pB(makePtrB(idB));
-    
-    association->addSingle(pA, pB);
+    m_association->addSingle(this->GetPtrMaker(m_pPtrMakerA)(idA), pB);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-    
+
 template <typename A, typename B>
-inline void LArPandoraOutput::AddAssociation(const art::Event &event, const art::EDProducer *const,
-    const std::string &instanceLabel, const size_t idA, const IdToIdVectorMap &aToBMap, std::unique_ptr< art::Assns<A, B> > &association)
+inline void AssociationBuilder<A, B>::Add(const size_t idA, const std::vector<size_t> &idBVector)
 {
-    IdToIdVectorMap::const_iterator it(aToBMap.find(idA));
-    if (it == aToBMap.end())
-        throw cet::exception("LArPandora") << " LArPandoraOutput::AddAssociation --- id doesn't exists in the assocaition map";
+    if (idBVector.empty())
+        return;
 
-    const art::PtrMaker<A> makePtrA(event, instanceLabel);
-    art::Ptr<A> pA(makePtrA(idA));
+    const art::Ptr<A> pA(this->GetPtrMaker(m_pPtrMakerA)(idA));
+    const art::PtrMaker<B> &makePtrB(this->GetPtrMaker(m_pPtrMakerB));
 
-    const art::PtrMaker<B> makePtrB(event, instanceLabel);
-    for (const size_t idB : it->second)
-    {
-        art::Ptr<B> pB(makePtrB(idB));
-        association->addSingle(pA, pB);
-    }
+    for (const size_t idB : idBVector)
+        m_association->addSingle(pA, makePtrB(idB));
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-    
+
 template <typename A, typename B>
-inline void LArPandoraOutput::AddAssociation(const art::Event &event, const art::EDProducer *const,
-    const std::string &instanceLabel, const size_t idA, const std::vector< art::Ptr<B> > &bVector,
-    std::unique_ptr< art::Assns<A, B> > &association)
+inline void AssociationBuilder<A, B>::Add(const size_t idA, const std::vector< art::Ptr<B> > &bVector)
 {
-    const art::PtrMaker<A> makePtrA(event, instanceLabel);
-    art::Ptr<A> pA(makePtrA(idA));
-    
+    if (bVector.empty())
+        return;
+
+    const art::Ptr<A> pA(this->GetPtrMaker(m_pPtrMakerA)(idA));
+
     for (const art::Ptr<B> &pB : bVector)
-        association->addSingle(pA, pB);
+        m_association->addSingle(pA, pB);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename A, typename B>
+template <typename T>
+inline const art::PtrMaker<T> &AssociationBuilder<A, B>::GetPtrMaker(std::unique_ptr< const art::PtrMaker<T> > &pPtrMaker) const
+{
+    // ATTN Created lazily, as a ptr maker can only be made for a product declared by this module, e.g. not for the input hits
+    if (!pPtrMaker)
+        pPtrMaker.reset(new art::PtrMaker<T>(m_event, m_instanceLabel));
+
+    return *pPtrMaker;
 }
 
 } // namespace lar_pandora
@@ -0,0 +1,162 @@
+/**
+ *  @file   larpandora/LArPandoraInterface/LArPandoraPooledObjects.cxx
+ *
+ *  @brief  Pool-backed pandora input objects and their factories, recycling object storage across events
+ */
+
+#include "cetlib_except/exception.h"
+
+#include "larpandora/LArPandoraInterface/LArPandoraPooledObjects.h"
+
+#include <algorithm>
+#include <new>
+
+namespace lar_pandora
+{
+
+LArObjectPool::LArObjectPool(const size_t blockSize, const size_t blocksPerChunk) :
+    m_blockSize(((std::max(blockSize, sizeof(FreeBlock)) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t)) * alignof(std::max_align_t)),
+    m_blocksPerChunk(blocksPerChunk),
+    m_pFreeList(nullptr),
+    m_nAllocations(0),
+    m_nChunkAllocations(0)
+{
+    if (0 == m_blocksPerChunk)
+        throw cet::exception("LArPandora") << " LArObjectPool::LArObjectPool --- chunks must contain at least one block ";
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArObjectPool::~LArObjectPool()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void *LArObjectPool::Allocate()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_pFreeList)
+    {
+        // ATTN The storage from new char[] is suitably aligned for any object of a fundamental alignment requirement
+        m_chunkList.emplace_back(new char[m_blockSize * m_blocksPerChunk]);
+        char *const pChunk(m_chunkList.back().get());
+
+        for (size_t iBlock = m_blocksPerChunk; iBlock > 0; --iBlock)
+        {
+            FreeBlock *const pFreeBlock(reinterpret_cast<FreeBlock*>(pChunk + (iBlock - 1) * m_blockSize));
+            pFreeBlock->m_pNext = m_pFreeList;
+            m_pFreeList = pFreeBlock;
+        }
+
+        ++m_nChunkAllocations;
+    }
+
+    FreeBlock *const pBlock(m_pFreeList);
+    m_pFreeList = pBlock->m_pNext;
+    ++m_nAllocations;
+
+    return pBlock;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArObjectPool::Release(void *const pBlock)
+{
+    if (!pBlock)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FreeBlock *const pFreeBlock(static_cast<FreeBlock*>(pBlock));
+    pFreeBlock->m_pNext = m_pFreeList;
+    m_pFreeList = pFreeBlock;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void *LArPooledCaloHit::operator new(std::size_t size)
+{
+    LArObjectPool &pool(LArPooledCaloHit::GetPool());
+    return ((size <= pool.GetBlockSize()) ? pool.Allocate() : ::operator new(size));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPooledCaloHit::operator delete(void *pObject, std::size_t size)
+{
+    LArObjectPool &pool(LArPooledCaloHit::GetPool());
+
+    if (size <= pool.GetBlockSize())
+    {
+        pool.Release(pObject);
+    }
+    else
+    {
+        ::operator delete(pObject);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArObjectPool &LArPooledCaloHit::GetPool()
+{
+    static LArObjectPool pool(sizeof(LArPooledCaloHit), 4096);
+    return pool;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+pandora::StatusCode LArPooledCaloHitFactory::Create(const Parameters &parameters, const Object *&pObject) const
+{
+    const lar_content::LArCaloHitParameters &larCaloHitParameters(dynamic_cast<const lar_content::LArCaloHitParameters&>(parameters));
+    pObject = new LArPooledCaloHit(larCaloHitParameters);
+
+    return pandora::STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void *LArPooledMCParticle::operator new(std::size_t size)
+{
+    LArObjectPool &pool(LArPooledMCParticle::GetPool());
+    return ((size <= pool.GetBlockSize()) ? pool.Allocate() : ::operator new(size));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArPooledMCParticle::operator delete(void *pObject, std::size_t size)
+{
+    LArObjectPool &pool(LArPooledMCParticle::GetPool());
+
+    if (size <= pool.GetBlockSize())
+    {
+        pool.Release(pObject);
+    }
+    else
+    {
+        ::operator delete(pObject);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArObjectPool &LArPooledMCParticle::GetPool()
+{
+    static LArObjectPool pool(sizeof(LArPooledMCParticle), 1024);
+    return pool;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+pandora::StatusCode LArPooledMCParticleFactory::Create(const Parameters &parameters, const Object *&pObject) const
+{
+    const lar_content::LArMCParticleParameters &larMCParticleParameters(dynamic_cast<const lar_content::LArMCParticleParameters&>(parameters));
+    pObject = new LArPooledMCParticle(larMCParticleParameters);
+
+    return pandora::STATUS_CODE_SUCCESS;
+}
+
+} // namespace lar_pandora
@@ -0,0 +1,227 @@
+/**
+ *  @file   larpandora/LArPandoraInterface/LArPandoraPooledObjects.h
+ *
+ *  @brief  Pool-backed pandora input objects and their factories, recycling object storage across events
+ */
+
+#ifndef LAR_PANDORA_POOLED_OBJECTS_H
+#define LAR_PANDORA_POOLED_OBJECTS_H 1
+
+#include "larpandoracontent/LArObjects/LArCaloHit.h"
+#include "larpandoracontent/LArObjects/LArMCParticle.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lar_pandora
+{
+
+/**
+ *  @brief  LArObjectPool class, handing out fixed-size blocks of storage. Blocks are carved from chunks allocated on the heap and, once
+ *          released, are kept on a free list for reuse rather than returned to the system. Allocation and release are thread-safe
+ */
+class LArObjectPool
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  blockSize the size of each block
+     *  @param  blocksPerChunk the number of blocks in each chunk taken from the heap
+     */
+    LArObjectPool(const size_t blockSize, const size_t blocksPerChunk);
+
+    /**
+     *  @brief  Destructor, returning all chunks to the heap
+     */
+    ~LArObjectPool();
+
+    /**
+     *  @brief  Take a block from the pool, allocating a new chunk if the free list is empty
+     *
+     *  @return the address of the block
+     */
+    void *Allocate();
+
+    /**
+     *  @brief  Return a block to the pool
+     *
+     *  @param  pBlock the address of the block
+     */
+    void Release(void *const pBlock);
+
+    /**
+     *  @brief  Get the size of each block
+     */
+    size_t GetBlockSize() const;
+
+    /**
+     *  @brief  Get the number of blocks taken from the pool, summed over the job
+     */
+    size_t GetNAllocations() const;
+
+    /**
+     *  @brief  Get the number of chunks taken from the heap, summed over the job
+     */
+    size_t GetNChunkAllocations() const;
+
+private:
+    /**
+     *  @brief  FreeBlock class, overlaid upon each block on the free list
+     */
+    class FreeBlock
+    {
+    public:
+        FreeBlock  *m_pNext;        ///< The address of the next block on the free list
+    };
+
+    typedef std::vector<std::unique_ptr<char[]>> ChunkList;
+
+    const size_t                m_blockSize;            ///< The size of each block, rounded up to the maximum fundamental alignment
+    const size_t                m_blocksPerChunk;       ///< The number of blocks in each chunk
+    std::mutex                  m_mutex;                ///< Guards the free list and the chunk list
+    FreeBlock                  *m_pFreeList;            ///< The first block on the free list
+    ChunkList                   m_chunkList;            ///< The chunks taken from the heap
+    std::atomic<size_t>         m_nAllocations;         ///< The number of blocks taken from the pool
+    std::atomic<size_t>         m_nChunkAllocations;    ///< The number of chunks taken from the heap
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  LArPooledCaloHit class, a lar calo hit whose storage is taken from, and returned to, a process-wide pool. Pandora deletes its
+ *          calo hits through a pointer to the base class, and the virtual destructor routes the deallocation here
+ */
+class LArPooledCaloHit : public lar_content::LArCaloHit
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  parameters the lar calo hit parameters
+     */
+    LArPooledCaloHit(const lar_content::LArCaloHitParameters &parameters);
+
+    /**
+     *  @brief  Allocate storage from the pool
+     *
+     *  @param  size the size of the object
+     */
+    static void *operator new(std::size_t size);
+
+    /**
+     *  @brief  Return storage to the pool
+     *
+     *  @param  pObject the address of the object
+     *  @param  size the size of the object
+     */
+    static void operator delete(void *pObject, std::size_t size);
+
+    /**
+     *  @brief  Get the pool
+     */
+    static LArObjectPool &GetPool();
+};
+
+/**
+ *  @brief  LArPooledCaloHitFactory class, creating pool-backed lar calo hits
+ */
+class LArPooledCaloHitFactory : public lar_content::LArCaloHitFactory
+{
+private:
+    pandora::StatusCode Create(const Parameters &parameters, const Object *&pObject) const;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  LArPooledMCParticle class, a lar mc particle whose storage is taken from, and returned to, a process-wide pool
+ */
+class LArPooledMCParticle : public lar_content::LArMCParticle
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  parameters the lar mc particle parameters
+     */
+    LArPooledMCParticle(const lar_content::LArMCParticleParameters &parameters);
+
+    /**
+     *  @brief  Allocate storage from the pool
+     *
+     *  @param  size the size of the object
+     */
+    static void *operator new(std::size_t size);
+
+    /**
+     *  @brief  Return storage to the pool
+     *
+     *  @param  pObject the address of the object
+     *  @param  size the size of the object
+     */
+    static void operator delete(void *pObject, std::size_t size);
+
+    /**
+     *  @brief  Get the pool
+     */
+    static LArObjectPool &GetPool();
+};
+
+/**
+ *  @brief  LArPooledMCParticleFactory class, creating pool-backed lar mc particles
+ */
+class LArPooledMCParticleFactory : public lar_content::LArMCParticleFactory
+{
+private:
+    pandora::StatusCode Create(const Parameters &parameters, const Object *&pObject) const;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline size_t LArObjectPool::GetBlockSize() const
+{
+    return m_blockSize;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline size_t LArObjectPool::GetNAllocations() const
+{
+    return m_nAllocations;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline size_t LArObjectPool::GetNChunkAllocations() const
+{
+    return m_nChunkAllocations;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArPooledCaloHit::LArPooledCaloHit(const lar_content::LArCaloHitParameters &parameters) :
+    lar_content::LArCaloHit(parameters)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArPooledMCParticle::LArPooledMCParticle(const lar_content::LArMCParticleParameters &parameters) :
+    lar_content::LArMCParticle(parameters)
+{
+}
+
+} // namespace lar_pandora
+
+#endif // #ifndef LAR_PANDORA_POOLED_OBJECTS_H
@@ -0,0 +1,180 @@
+/**
+ *  @file   larpandora/LArPandoraInterface/StandardPandora.cxx
+ *
+ *  @brief  A generic LArPandora ART Producer intended to work on ALL LAr-TPC wire-readout experiments.
+ */
+
+#include "cetlib/search_path.h"
+#include "cetlib_except/exception.h"
+
+#include "Api/PandoraApi.h"
+
+#include "larpandoracontent/LArContent.h"
+#include "larpandoracontent/LArControlFlow/MultiPandoraApi.h"
+#include "larpandoracontent/LArControlFlow/MasterAlgorithm.h"
+#include "larpandoracontent/LArPlugins/LArPseudoLayerPlugin.h"
+#include "larpandoracontent/LArPlugins/LArRotationalTransformationPlugin.h"
+
+#include "larpandora/LArPandoraInterface/StandardPandora.h"
+
+#include <iostream>
+
+namespace lar_pandora
+{
+
+template <typename TProducer>
+StandardPandoraT<TProducer>::StandardPandoraT(fhicl::ParameterSet const &pset) :
+    LArPandoraT<TProducer>(pset)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+StandardPandoraT<TProducer>::StandardPandoraT(fhicl::ParameterSet const &pset, art::ProcessingFrame const &frame) :
+    LArPandoraT<TProducer>(pset, &frame)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+StandardPandoraT<TProducer>::~StandardPandoraT()
+{
+    this->DeletePandoraInstances();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void StandardPandoraT<TProducer>::CreatePandoraInstances()
+{
+    m_pPrimaryPandora = this->CreateLArPandoraInstance();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void StandardPandoraT<TProducer>::ConfigurePandoraInstances()
+{
+    this->ConfigureLArPandoraInstance(m_pPrimaryPandora, false);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void StandardPandoraT<TProducer>::RunPandoraInstances()
+{
+    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*m_pPrimaryPandora));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void StandardPandoraT<TProducer>::ResetPandoraInstances()
+{
+    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*m_pPrimaryPandora));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void StandardPandoraT<TProducer>::DeletePandoraInstances()
+{
+    MultiPandoraApi::DeletePandoraInstances(m_pPrimaryPandora);
+
+    if (m_pFallbackPandora)
+        MultiPandoraApi::DeletePandoraInstances(m_pFallbackPandora);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void StandardPandoraT<TProducer>::CreateFallbackPandoraInstance()
+{
+    m_pFallbackPandora = this->CreateLArPandoraInstance();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void StandardPandoraT<TProducer>::ConfigureFallbackPandoraInstance()
+{
+    this->ConfigureLArPandoraInstance(m_pFallbackPandora, true);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void StandardPandoraT<TProducer>::RunFallbackPandoraInstance()
+{
+    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*m_pFallbackPandora));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void StandardPandoraT<TProducer>::ResetFallbackPandoraInstance()
+{
+    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*m_pFallbackPandora));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+const pandora::Pandora *StandardPandoraT<TProducer>::CreateLArPandoraInstance() const
+{
+    const pandora::Pandora *const pPandora(new pandora::Pandora());
+    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LArContent::RegisterAlgorithms(*pPandora));
+    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LArContent::RegisterBasicPlugins(*pPandora));
+
+    // ATTN Potentially ill defined, unless coordinate system set up to ensure that all drift volumes have same wire angles and pitches
+    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetPseudoLayerPlugin(*pPandora, new lar_content::LArPseudoLayerPlugin));
+    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetLArTransformationPlugin(*pPandora, new lar_content::LArRotationalTransformationPlugin));
+
+    // ATTN For replicated producers, the multi pandora api map is shared by the replicas, but is only modified in beginJob and at destruction,
+    // which art serialises
+    MultiPandoraApi::AddPrimaryPandoraInstance(pPandora);
+
+    return pPandora;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void StandardPandoraT<TProducer>::ConfigureLArPandoraInstance(const pandora::Pandora *const pPandora, const bool isFallback) const
+{
+    cet::search_path sp("FW_SEARCH_PATH");
+    std::string fullConfigFileName;
+
+    if (!sp.find_file(m_configFile, fullConfigFileName))
+        throw cet::exception("StandardPandora") << " ConfigurePrimaryPandoraInstance - Failed to find xml configuration file " << m_configFile << " in FW search path";
+
+    this->ProvideExternalSteeringParameters(pPandora, isFallback);
+    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pPandora, fullConfigFileName));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TProducer>
+void StandardPandoraT<TProducer>::ProvideExternalSteeringParameters(const pandora::Pandora *const pPandora, const bool isFallback) const
+{
+    // ATTN The fallback steering keeps the stitching, so that the same products are written, but skips the slicing and slice reconstruction
+    auto *const pEventSteeringParameters = new lar_content::MasterAlgorithm::ExternalSteeringParameters;
+    pEventSteeringParameters->m_shouldRunAllHitsCosmicReco = (isFallback || m_shouldRunAllHitsCosmicReco);
+    pEventSteeringParameters->m_shouldRunStitching = m_shouldRunStitching;
+    pEventSteeringParameters->m_shouldRunCosmicHitRemoval = (!isFallback && m_shouldRunCosmicHitRemoval);
+    pEventSteeringParameters->m_shouldRunSlicing = (!isFallback && m_shouldRunSlicing);
+    pEventSteeringParameters->m_shouldRunNeutrinoRecoOption = (!isFallback && m_shouldRunNeutrinoRecoOption);
+    pEventSteeringParameters->m_shouldRunCosmicRecoOption = (!isFallback && m_shouldRunCosmicRecoOption);
+    pEventSteeringParameters->m_shouldPerformSliceId = (!isFallback && m_shouldPerformSliceId);
+    pEventSteeringParameters->m_printOverallRecoStatus = m_printOverallRecoStatus;
+    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, pandora::ExternallyConfiguredAlgorithm::SetExternalParameters(*pPandora, "LArMaster", pEventSteeringParameters));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template class StandardPandoraT<art::EDProducer>;
+template class StandardPandoraT<art::ReplicatedProducer>;
+
+} // namespace lar_pandora
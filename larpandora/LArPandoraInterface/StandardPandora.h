@@ -0,0 +1,95 @@
+/**
+ *  @file   larpandora/LArPandoraInterface/StandardPandora.h
+ *
+ *  @brief  A generic LArPandora ART Producer intended to work on ALL LAr-TPC wire-readout experiments.
+ */
+
+#ifndef STANDARD_PANDORA_H
+#define STANDARD_PANDORA_H 1
+
+#include "larpandora/LArPandoraInterface/LArPandora.h"
+
+namespace lar_pandora
+{
+
+/**
+ *  @brief  StandardPandoraT class template, on top of art::EDProducer for the StandardPandora module or art::ReplicatedProducer. No replicated
+ *          module is defined, as the geometry, detector, channel status and TFileService services it would use are still legacy services
+ */
+template <typename TProducer>
+class StandardPandoraT : public LArPandoraT<TProducer>
+{
+public:
+    /**
+     *  @brief  Constructor, for a legacy producer
+     *
+     *  @param  pset the parameter set
+     */
+    StandardPandoraT(fhicl::ParameterSet const &pset);
+
+    /**
+     *  @brief  Constructor, for a replicated producer
+     *
+     *  @param  pset the parameter set
+     *  @param  frame the processing frame of the schedule that owns this replica
+     */
+    StandardPandoraT(fhicl::ParameterSet const &pset, art::ProcessingFrame const &frame);
+
+    /**
+     *  @brief  Destructor
+     */
+    ~StandardPandoraT();
+
+private:
+    using LArPandoraT<TProducer>::m_pPrimaryPandora;
+    using LArPandoraT<TProducer>::m_pFallbackPandora;
+    using LArPandoraT<TProducer>::m_configFile;
+    using LArPandoraT<TProducer>::m_shouldRunAllHitsCosmicReco;
+    using LArPandoraT<TProducer>::m_shouldRunStitching;
+    using LArPandoraT<TProducer>::m_shouldRunCosmicHitRemoval;
+    using LArPandoraT<TProducer>::m_shouldRunSlicing;
+    using LArPandoraT<TProducer>::m_shouldRunNeutrinoRecoOption;
+    using LArPandoraT<TProducer>::m_shouldRunCosmicRecoOption;
+    using LArPandoraT<TProducer>::m_shouldPerformSliceId;
+    using LArPandoraT<TProducer>::m_printOverallRecoStatus;
+
+    void CreatePandoraInstances();
+    void ConfigurePandoraInstances();
+    void RunPandoraInstances();
+    void ResetPandoraInstances();
+    void DeletePandoraInstances();
+    void CreateFallbackPandoraInstance();
+    void ConfigureFallbackPandoraInstance();
+    void RunFallbackPandoraInstance();
+    void ResetFallbackPandoraInstance();
+
+    /**
+     *  @brief  Create a pandora instance, with the lar content algorithms and plugins registered, and register it as a primary instance
+     *
+     *  @return the address of the new pandora instance
+     */
+    const pandora::Pandora *CreateLArPandoraInstance() const;
+
+    /**
+     *  @brief  Provide the external steering parameters to a pandora instance and read its xml configuration file
+     *
+     *  @param  pPandora the address of the relevant pandora instance
+     *  @param  isFallback whether to use the fallback steering, rather than that read from the fhicl parameter set
+     */
+    void ConfigureLArPandoraInstance(const pandora::Pandora *const pPandora, const bool isFallback) const;
+
+    /**
+     *  @brief  Pass external steering parameters, read from fhicl parameter set, to LArMaster Pandora algorithm
+     * 
+     *  @param  pPandora the address of the relevant pandora instance
+     *  @param  isFallback whether to use the fallback steering, which runs only the cosmic-ray reconstruction of all hits
+     */
+    void ProvideExternalSteeringParameters(const pandora::Pandora *const pPandora, const bool isFallback) const;
+};
+
+typedef StandardPandoraT<art::EDProducer> StandardPandora;
+typedef StandardPandoraT<art::ReplicatedProducer> ReplicatedStandardPandora;
+
+} // namespace lar_pandora
+
+#endif // #ifndef STANDARD_PANDORA_H
@@ -0,0 +1,64 @@
+/**
+ *  @file   larpandora/LArPandoraObjects/CompactSpacePoints.cxx
+ *
+ *  @brief  Compact, quantised storage of the 3D hit positions of a PFParticle collection
+ */
+
+#include "cetlib_except/exception.h"
+
+#include "larpandora/LArPandoraObjects/CompactSpacePoints.h"
+
+#include <cmath>
+#include <limits>
+
+namespace larpandoraobj
+{
+
+CompactSpacePoints::CompactSpacePoints() :
+    m_resolution(0.f),
+    m_particleOffsets(1, 0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CompactSpacePoints::CompactSpacePoints(const float resolution) :
+    m_resolution(resolution),
+    m_particleOffsets(1, 0)
+{
+    if (!(m_resolution > 0.f) || !std::isfinite(m_resolution))
+        throw cet::exception("LArPandora") << " CompactSpacePoints::CompactSpacePoints --- invalid resolution " << m_resolution;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CompactSpacePoints::AddPoint(const double x, const double y, const double z)
+{
+    if (m_x.size() >= std::numeric_limits<uint32_t>::max())
+        throw cet::exception("LArPandora") << " CompactSpacePoints::AddPoint --- too many points ";
+
+    m_x.push_back(this->Quantise(x));
+    m_y.push_back(this->Quantise(y));
+    m_z.push_back(this->Quantise(z));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CompactSpacePoints::CloseParticle()
+{
+    m_particleOffsets.push_back(static_cast<uint32_t>(m_x.size()));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int32_t CompactSpacePoints::Quantise(const double coordinate) const
+{
+    const double count(std::round(coordinate / m_resolution));
+
+    if (!(std::fabs(count) <= static_cast<double>(std::numeric_limits<int32_t>::max())))
+        throw cet::exception("LArPandora") << " CompactSpacePoints::Quantise --- coordinate " << coordinate << " can't be represented at resolution " << m_resolution;
+
+    return static_cast<int32_t>(count);
+}
+
+} // namespace larpandoraobj
@@ -0,0 +1,174 @@
+/**
+ *  @file   larpandora/LArPandoraObjects/CompactSpacePoints.h
+ *
+ *  @brief  Compact, quantised storage of the 3D hit positions of a PFParticle collection
+ */
+
+#ifndef LAR_PANDORA_COMPACT_SPACE_POINTS_H
+#define LAR_PANDORA_COMPACT_SPACE_POINTS_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace larpandoraobj
+{
+
+/**
+ *  @brief  CompactSpacePoints class, holding the 3D hit positions of the PFParticles in a collection as fixed-point coordinates,
+ *          in structure-of-arrays form. The points of the PFParticle with a given index in its collection are those with indices
+ *          in the range [ParticleBegin(index), ParticleEnd(index))
+ */
+class CompactSpacePoints
+{
+public:
+    /**
+     *  @brief  Default constructor, required for persistency
+     */
+    CompactSpacePoints();
+
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  resolution the coordinate resolution (cm)
+     */
+    explicit CompactSpacePoints(const float resolution);
+
+    /**
+     *  @brief  Add a point to the current particle
+     *
+     *  @param  x the x coordinate (cm)
+     *  @param  y the y coordinate (cm)
+     *  @param  z the z coordinate (cm)
+     */
+    void AddPoint(const double x, const double y, const double z);
+
+    /**
+     *  @brief  Close the current particle, so that subsequent points are added to the next particle
+     */
+    void CloseParticle();
+
+    /**
+     *  @brief  Get the number of closed particles
+     */
+    size_t NParticles() const;
+
+    /**
+     *  @brief  Get the total number of points
+     */
+    size_t NPoints() const;
+
+    /**
+     *  @brief  Get the index of the first point of a particle
+     *
+     *  @param  particleIndex the index of the particle
+     */
+    size_t ParticleBegin(const size_t particleIndex) const;
+
+    /**
+     *  @brief  Get the index one beyond the last point of a particle
+     *
+     *  @param  particleIndex the index of the particle
+     */
+    size_t ParticleEnd(const size_t particleIndex) const;
+
+    /**
+     *  @brief  Get the x coordinate of a point (cm)
+     *
+     *  @param  pointIndex the index of the point
+     */
+    double X(const size_t pointIndex) const;
+
+    /**
+     *  @brief  Get the y coordinate of a point (cm)
+     *
+     *  @param  pointIndex the index of the point
+     */
+    double Y(const size_t pointIndex) const;
+
+    /**
+     *  @brief  Get the z coordinate of a point (cm)
+     *
+     *  @param  pointIndex the index of the point
+     */
+    double Z(const size_t pointIndex) const;
+
+    /**
+     *  @brief  Get the coordinate resolution (cm)
+     */
+    float Resolution() const;
+
+private:
+    /**
+     *  @brief  Convert a coordinate to its fixed-point representation
+     *
+     *  @param  coordinate the coordinate (cm)
+     */
+    int32_t Quantise(const double coordinate) const;
+
+    float                   m_resolution;           ///< The coordinate resolution (cm)
+    std::vector<int32_t>    m_x;                    ///< The x coordinates, in units of the resolution
+    std::vector<int32_t>    m_y;                    ///< The y coordinates, in units of the resolution
+    std::vector<int32_t>    m_z;                    ///< The z coordinates, in units of the resolution
+    std::vector<uint32_t>   m_particleOffsets;      ///< The index of the first point of each particle, followed by the number of points
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline size_t CompactSpacePoints::NParticles() const
+{
+    return (m_particleOffsets.size() - 1);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline size_t CompactSpacePoints::NPoints() const
+{
+    return m_x.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline size_t CompactSpacePoints::ParticleBegin(const size_t particleIndex) const
+{
+    return m_particleOffsets.at(particleIndex);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline size_t CompactSpacePoints::ParticleEnd(const size_t particleIndex) const
+{
+    return m_particleOffsets.at(particleIndex + 1);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double CompactSpacePoints::X(const size_t pointIndex) const
+{
+    return m_resolution * static_cast<double>(m_x.at(pointIndex));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double CompactSpacePoints::Y(const size_t pointIndex) const
+{
+    return m_resolution * static_cast<double>(m_y.at(pointIndex));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double CompactSpacePoints::Z(const size_t pointIndex) const
+{
+    return m_resolution * static_cast<double>(m_z.at(pointIndex));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline float CompactSpacePoints::Resolution() const
+{
+    return m_resolution;
+}
+
+} // namespace larpandoraobj
+
+#endif // #ifndef LAR_PANDORA_COMPACT_SPACE_POINTS_H
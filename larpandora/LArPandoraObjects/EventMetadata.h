@@ -0,0 +1,156 @@
+/**
+ *  @file   larpandora/LArPandoraObjects/EventMetadata.h
+ *
+ *  @brief  Event-level record of the reconstruction budget applied by LArPandora
+ */
+
+#ifndef LAR_PANDORA_EVENT_METADATA_H
+#define LAR_PANDORA_EVENT_METADATA_H 1
+
+namespace larpandoraobj
+{
+
+/**
+ *  @brief  EventMetadata class, recording the number of hits in an event, whether it exceeded the reconstruction budget and, if so, which
+ *          fallback was used in place of the full reconstruction
+ */
+class EventMetadata
+{
+public:
+    /**
+     *  @brief  Fallback enumeration
+     */
+    enum Fallback
+    {
+        kNoFallback = 0,            // The full reconstruction was run
+        kCosmicOnlyFallback = 1,    // Only the cosmic-ray reconstruction of all hits was run
+        kEmptyFallback = 2          // No reconstruction was run, and empty products were written
+    };
+
+    /**
+     *  @brief  Default constructor, required for persistency
+     */
+    EventMetadata();
+
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  fallback the fallback used
+     *  @param  nHits the number of hits passed to the reconstruction budget
+     *  @param  isHitBudgetExceeded whether the number of hits exceeded the budget
+     *  @param  isTimeBudgetExceeded whether the predicted reconstruction time exceeded the budget
+     *  @param  predictedSeconds the predicted time for the full reconstruction (s)
+     *  @param  runSeconds the time spent running the reconstruction (s)
+     */
+    EventMetadata(const Fallback fallback, const unsigned int nHits, const bool isHitBudgetExceeded, const bool isTimeBudgetExceeded,
+        const float predictedSeconds, const float runSeconds);
+
+    /**
+     *  @brief  Get the fallback used
+     */
+    Fallback GetFallback() const;
+
+    /**
+     *  @brief  Get the number of hits passed to the reconstruction budget
+     */
+    unsigned int GetNHits() const;
+
+    /**
+     *  @brief  Whether the number of hits exceeded the budget
+     */
+    bool IsHitBudgetExceeded() const;
+
+    /**
+     *  @brief  Whether the predicted reconstruction time exceeded the budget
+     */
+    bool IsTimeBudgetExceeded() const;
+
+    /**
+     *  @brief  Get the predicted time for the full reconstruction (s), zero if there was no prediction
+     */
+    float GetPredictedSeconds() const;
+
+    /**
+     *  @brief  Get the time spent running the reconstruction (s)
+     */
+    float GetRunSeconds() const;
+
+private:
+    unsigned int    m_fallback;                 ///< The fallback used
+    unsigned int    m_nHits;                    ///< The number of hits passed to the reconstruction budget
+    bool            m_isHitBudgetExceeded;      ///< Whether the number of hits exceeded the budget
+    bool            m_isTimeBudgetExceeded;     ///< Whether the predicted reconstruction time exceeded the budget
+    float           m_predictedSeconds;         ///< The predicted time for the full reconstruction (s)
+    float           m_runSeconds;               ///< The time spent running the reconstruction (s)
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline EventMetadata::EventMetadata() :
+    m_fallback(kNoFallback),
+    m_nHits(0),
+    m_isHitBudgetExceeded(false),
+    m_isTimeBudgetExceeded(false),
+    m_predictedSeconds(0.f),
+    m_runSeconds(0.f)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline EventMetadata::EventMetadata(const Fallback fallback, const unsigned int nHits, const bool isHitBudgetExceeded, const bool isTimeBudgetExceeded,
+        const float predictedSeconds, const float runSeconds) :
+    m_fallback(fallback),
+    m_nHits(nHits),
+    m_isHitBudgetExceeded(isHitBudgetExceeded),
+    m_isTimeBudgetExceeded(isTimeBudgetExceeded),
+    m_predictedSeconds(predictedSeconds),
+    m_runSeconds(runSeconds)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline EventMetadata::Fallback EventMetadata::GetFallback() const
+{
+    return static_cast<Fallback>(m_fallback);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int EventMetadata::GetNHits() const
+{
+    return m_nHits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool EventMetadata::IsHitBudgetExceeded() const
+{
+    return m_isHitBudgetExceeded;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool EventMetadata::IsTimeBudgetExceeded() const
+{
+    return m_isTimeBudgetExceeded;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline float EventMetadata::GetPredictedSeconds() const
+{
+    return m_predictedSeconds;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline float EventMetadata::GetRunSeconds() const
+{
+    return m_runSeconds;
+}
+
+} // namespace larpandoraobj
+
+#endif // #ifndef LAR_PANDORA_EVENT_METADATA_H
@@ -0,0 +1,10 @@
+/**
+ *  @file   larpandora/LArPandoraObjects/classes.h
+ *
+ *  @brief  Dictionary definitions for the LArPandora data products
+ */
+
+#include "canvas/Persistency/Common/Wrapper.h"
+
+#include "larpandora/LArPandoraObjects/CompactSpacePoints.h"
+#include "larpandora/LArPandoraObjects/EventMetadata.h"